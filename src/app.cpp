@@ -10,9 +10,58 @@ void App::LogUnknownEvent(const etl::imessage& msg) {
 }
 
 App app;
+App::Tracer appTracer;
+
+void App::dispatch() {
+    QueueItem item;
+
+    while (queue.pop(item)) {
+        const etl::imessage& msg = item.packet.get();
+
+        if (!tracer) {
+            receive(msg);
+            continue;
+        }
+
+        const uint8_t from = uint8_t(get_state_id());
+        const uint32_t start = micros();
+        receive(msg);
+        const uint32_t end = micros();
+
+        tracer->record({ start - item.posted_us, end - start,
+            uint8_t(msg.get_message_id()), from, uint8_t(get_state_id()) });
+    }
+}
+
+namespace {
+
+TaskHandle_t dispatcher_task = nullptr;
+
+void app_dispatcher_thread(void* pvParameters) {
+    app.start();
+
+    while (true) {
+        app.dispatch();
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+}
+
+void App::notifyDispatcher() {
+    // Messages, posted before dispatcher start, will be processed at start
+    if (dispatcher_task) xTaskNotifyGive(dispatcher_task);
+}
+
+void App::onQueueFull(const etl::imessage& msg) {
+    DEBUG("APP: Queue full, event dropped! msg id [{}]", int(msg.get_message_id()));
+}
 
 void app_init() {
     app_states_init(app);
-    app.start();
+    app.setTracer(&appTracer);
+
+    // All FSM processing happens in this task, in order of posting
+    xTaskCreate(app_dispatcher_thread, "app_dispatcher", 1024 * 4, NULL, 1, &dispatcher_task);
 }
 
@@ -1,7 +1,10 @@
 #pragma once
 
 #include "etl/fsm.h"
+#include "etl/message_packet.h"
 #include "button/button.hpp"
+#include "utils/ring_queue.hpp"
+#include "utils/fsm_tracer.hpp"
 
 struct AppEventId {
     enum Enum {
@@ -25,14 +28,48 @@ public:
 };
 
 
+using AppMessagePacket = etl::message_packet<Start, Stop, BondOn, BondOff, ButtonAction>;
+
 class App : public etl::fsm {
 public:
     App();
 
     void LogUnknownEvent(const etl::imessage& msg);
+
+    // Queue message for dispatcher task. Safe to call from any task, never
+    // blocks. Returns false if queue is full and message was dropped.
+    template <typename TMessage>
+    bool post(const TMessage& msg) {
+        if (!queue.push({ AppMessagePacket(msg), micros() })) {
+            onQueueFull(msg);
+            return false;
+        }
+        notifyDispatcher();
+        return true;
+    }
+
+    // Process all queued messages in order. Dispatcher task only.
+    void dispatch();
+
+    // Optional events tracing, disabled when null
+    using Tracer = FsmTracer<8, 32>;
+    void setTracer(Tracer* t) { tracer = t; }
+
+private:
+    struct QueueItem {
+        AppMessagePacket packet;
+        uint32_t posted_us;
+    };
+
+    MpscRingQueue<QueueItem, 16> queue;
+    Tracer* tracer = nullptr;
+
+    void notifyDispatcher();
+    void onQueueFull(const etl::imessage& msg);
 };
 
 extern App app;
+extern App::Tracer appTracer;
 
 void app_init();
 void app_states_init(App& app);
@@ -52,12 +52,12 @@ public:
             // Animate long press start
             case ButtonEventId::BUTTON_LONG_PRESS_START:
                 DEBUG("Long press start");
-                blinker.once(BLINK_LONG_PRESS_START);
+                blinker.once(BLINK_LONG_PRESS_START, BLINK_LAYER_FEEDBACK);
                 break;
             // Stops animation if long press not reached
             case ButtonEventId::BUTTON_LONG_PRESS_FAIL:
                 DEBUG("Long press fail");
-                blinker.off();
+                blinker.off(BLINK_LAYER_FEEDBACK);
                 break;
             
             case ButtonEventId::BUTTON_LONG_PRESS:
@@ -82,7 +82,7 @@ public:
     etl::fsm_state_id_t on_enter_state() {
         // Temporary stub
         DEBUG("Working entered");
-        blinker.once({ {0, 200}, {255, 300}, {0, 200} });
+        blinker.once({ {0, 200}, {255, 300}, {0, 200} }, BLINK_LAYER_FEEDBACK);
         return AppStateId::IDLE;
     }
 
@@ -100,11 +100,11 @@ public:
     static constexpr uint32_t BONDING_PERIOD_MS = 15*1000;
 
     etl::fsm_state_id_t on_enter_state() {
-        blinker.loop(BLINK_BONDING_LOOP);
+        blinker.loop(BLINK_BONDING_LOOP, BLINK_LAYER_STATUS);
 
         // Enable bonding for 30 seconds
         xTimeoutTimer = xTimerCreate("BondingTimeout", pdMS_TO_TICKS(BONDING_PERIOD_MS), pdFALSE, (void *)0,
-            [](TimerHandle_t xTimer){ app.receive(BondOff()); });
+            [](TimerHandle_t xTimer){ app.post(BondOff()); });
 
         // Ideally, we should check all returned statuses, but who cares...
         if (xTimeoutTimer) xTimerStart(xTimeoutTimer, 0);
@@ -120,7 +120,7 @@ public:
             xTimeoutTimer = nullptr;
         }
         pairing_disable();
-        blinker.off();
+        blinker.off(BLINK_LAYER_STATUS);
     }
 
     etl::fsm_state_id_t on_event(const BondOff& event) { return AppStateId::IDLE; }
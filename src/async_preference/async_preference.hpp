@@ -1,55 +1,306 @@
 #pragma once
 
 #include <cstdint>
-#include <string>
+#include <cstdio>
+#include <cstring>
 #include <atomic>
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include <vector>
 #include <type_traits>
 #include "utils/data_guard.hpp"
+#include "utils/log2_histogram.hpp"
+
+// Preference key: namespace + name, with precomputed hash. Only pointers are
+// stored, so strings must have static storage duration (use literals). When
+// declared `constexpr`, hash is calculated at compile time.
+struct PreferenceKey {
+    // NVS key length limit. Full names, with page suffix, should fit it.
+    static constexpr size_t MAX_NAME_LENGTH = 15;
+
+    const char* ns;
+    const char* name;
+    uint32_t hash;
+    uint16_t page; // 0 => plain key, N => key of page N-1, named "<name>.<N-1>"
+
+    constexpr PreferenceKey(const char* ns, const char* name)
+        : ns(ns), name(name), hash(hashOf(ns, name)), page(0) {}
+
+    // Derived key for page of big value. Hash is the same as for plain key
+    // with "<name>.<idx>" name, so backends don't need special handling.
+    constexpr PreferenceKey pageKey(uint16_t idx) const {
+        PreferenceKey result = *this;
+        result.page = idx + 1;
+
+        char digits[5] = {};
+        int count = 0;
+        do { digits[count++] = char('0' + idx % 10); idx /= 10; } while (idx);
+
+        result.hash = (result.hash ^ uint8_t('.')) * 16777619u;
+        while (count) result.hash = (result.hash ^ uint8_t(digits[--count])) * 16777619u;
+        return result;
+    }
+
+    // Full name for backends, that need string key. Returns false, if name
+    // was truncated to buffer size - such key must not be used.
+    bool fullName(char* buffer, size_t size) const {
+        if (nameLength() >= size) {
+            if (size) buffer[0] = 0;
+            return false;
+        }
+
+        size_t pos = std::strlen(name);
+        std::memcpy(buffer, name, pos);
+
+        if (page) {
+            char digits[5];
+            int count = 0;
+            unsigned idx = page - 1u;
+            do { digits[count++] = char('0' + idx % 10); idx /= 10; } while (idx);
+
+            buffer[pos++] = '.';
+            while (count) buffer[pos++] = digits[--count];
+        }
+
+        buffer[pos] = 0;
+        return true;
+    }
+
+    // Length of full name, "<name>" or "<name>.<page>"
+    constexpr size_t nameLength() const {
+        size_t length = 0;
+        while (name[length]) length++;
+        if (!page) return length;
+
+        length += 2; // Dot & the first digit
+        for (unsigned idx = page - 1u; idx >= 10; idx /= 10) length++;
+        return length;
+    }
+
+    // True if names of key & its `pages` page keys fit MAX_NAME_LENGTH. For
+    // constexpr keys of paged values use in `static_assert`, to catch long
+    // names at compile time.
+    constexpr bool fitsPages(size_t pages) const {
+        if (nameLength() > MAX_NAME_LENGTH) return false;
+        return pages == 0 || (pages <= 65536 && pageKey(uint16_t(pages - 1)).nameLength() <= MAX_NAME_LENGTH);
+    }
+
+    // FNV-1a, with zero separator to distinguish "ns1"+"key" from "ns"+"1key"
+    static constexpr uint32_t hashOf(const char* ns, const char* name) {
+        uint32_t h = 2166136261u;
+        for (const char* p = ns; *p; p++) h = (h ^ uint8_t(*p)) * 16777619u;
+        h = h * 16777619u;
+        for (const char* p = name; *p; p++) h = (h ^ uint8_t(*p)) * 16777619u;
+        return h;
+    }
+};
 
 // Interface for key-value storage
 class IAsyncPreferenceKV {
 public:
-    virtual void write(const std::string& ns, const std::string& key, uint8_t* buffer, size_t length) = 0;
-    virtual void read(const std::string& ns, const std::string& key, uint8_t* buffer, size_t length) = 0;
-    virtual size_t length(const std::string& ns, const std::string& key) = 0;
+    virtual void write(const PreferenceKey& key, uint8_t* buffer, size_t length) = 0;
+    virtual void read(const PreferenceKey& key, uint8_t* buffer, size_t length) = 0;
+    virtual size_t length(const PreferenceKey& key) = 0;
+    // Delete key, if exists
+    virtual void remove(const PreferenceKey& key) = 0;
+
+    // Optional hint for bulk reads of one namespace, to let storage keep it
+    // open between calls.
+    virtual void batchBegin(const char* ns) { (void)ns; }
+    virtual void batchEnd() {}
 };
 
 namespace async_preference_ns {
 
+// Serializers provide static `save(kv, key, value)` and
+// `bool load(kv, key, value)`. Load returns false if nothing was loaded
+// (key missing or data broken), then the next save rewrites value
+// completely.
+
 // Serializer for trivially copyable types
 template <typename T>
 struct TrivialSerializer {
-    static void save(IAsyncPreferenceKV& kv, const std::string& ns, const std::string& key, const T& value) {
-        kv.write(ns, key, reinterpret_cast<uint8_t*>(const_cast<T*>(&value)), sizeof(T));
+    static void save(IAsyncPreferenceKV& kv, const PreferenceKey& key, const T& value) {
+        kv.write(key, reinterpret_cast<uint8_t*>(const_cast<T*>(&value)), sizeof(T));
     }
 
-    static void load(IAsyncPreferenceKV& kv, const std::string& ns, const std::string& key, T& value) {
-        const size_t size = kv.length(ns, key);
+    static bool load(IAsyncPreferenceKV& kv, const PreferenceKey& key, T& value) {
+        const size_t size = kv.length(key);
 
-        if (size == 0) return; // Key not exists => nothing to load
-        if (size != sizeof(T)) return; // Wrong size => broken data, ignore it
+        if (size == 0) return false; // Key not exists => nothing to load
+        if (size != sizeof(T)) return false; // Wrong size => broken data, ignore it
 
-        kv.read(ns, key, reinterpret_cast<uint8_t*>(&value), sizeof(T));
+        kv.read(key, reinterpret_cast<uint8_t*>(&value), sizeof(T));
+        return true;
     }
 };
 
 // Serializer for buffer-like types (with data(), size(), and resize())
-// Primary goal is to fit std::string and std::vector
+// Fits std::string and std::vector, and their fixed-capacity versions
+// etl::string<N> and etl::vector<T, N>, which do not use heap.
 template <typename T>
 struct BufferSerializer {
-    static void save(IAsyncPreferenceKV& kv, const std::string& ns, const std::string& key, const T& value) {
-        kv.write(ns, key, reinterpret_cast<uint8_t*>(const_cast<typename T::value_type*>(value.data())), value.size() * sizeof(typename T::value_type));
+    using Item = typename T::value_type;
+    static_assert(std::is_trivially_copyable_v<Item>, "Buffer items should be trivially copyable");
+
+    static void save(IAsyncPreferenceKV& kv, const PreferenceKey& key, const T& value) {
+        kv.write(key, reinterpret_cast<uint8_t*>(const_cast<Item*>(value.data())), value.size() * sizeof(Item));
+    }
+
+    static bool load(IAsyncPreferenceKV& kv, const PreferenceKey& key, T& value) {
+        size_t size = kv.length(key);
+
+        if (size == 0) return false; // Key not exists => nothing to load
+        if (size % sizeof(Item) != 0) return false; // Wrong size => broken data, ignore it
+        // Does not fit into fixed capacity => broken data (or capacity was
+        // reduced in new firmware). Reading it would overflow the buffer.
+        if (size / sizeof(Item) > value.max_size()) return false;
+
+        value.resize(size / sizeof(Item));
+        kv.read(key, reinterpret_cast<uint8_t*>(value.data()), size);
+        return true;
+    }
+};
+
+// Serializer for big values. Data is split into fixed-size pages, stored under
+// derived keys. Base key keeps total size in bytes. When dirty range of
+// snapshot is known, only changed pages are written, so flash wear is
+// proportional to the change, not to the value size. Pages beyond the new
+// size are removed on shrink.
+// Supports trivially copyable types and buffers of trivially copyable items.
+//
+// Stored size is kept in `State` of preference between calls, so storage is
+// not queried on every save.
+//
+// Page keys are named "<name>.<N>" and should fit NVS key limit (see
+// `PreferenceKey::fitsPages()`). Values with too long page names are not
+// saved nor loaded, instead of writing truncated (colliding) keys.
+template <typename T, size_t PageSize = 64>
+struct PagedSerializer {
+    // Size record in storage, as known by preference
+    struct State {
+        bool known = false;    // Size record was checked
+        bool has_size = false; // Size record exists (not legacy or missing)
+        uint32_t size = 0;
+    };
+
+    // Pages count of trivially copyable value, for compile-time key checks
+    static constexpr size_t pagesOf(size_t size) { return (size + PageSize - 1) / PageSize; }
+
+    static void save(IAsyncPreferenceKV& kv, const PreferenceKey& key, const T& value) {
+        State state;
+        save(kv, key, value, DataGuardDirty{ 0, 0, true }, state);
+    }
+
+    static void save(IAsyncPreferenceKV& kv, const PreferenceKey& key, const T& value, const DataGuardDirty& dirty, State& state) {
+        uint8_t* data = const_cast<uint8_t*>(bytes(value));
+        uint32_t size = static_cast<uint32_t>(bytesSize(value));
+
+        if (!key.fitsPages(pagesCount(size))) return;
+
+        if (!state.known) readSize(kv, key, state);
+
+        size_t first = 0;
+        size_t last = pagesCount(size);
+
+        // Without size record nothing can be reused
+        if (state.has_size && !dirty.all) {
+            if (dirty.empty() && state.size == size) return;
+            first = dirty.from / PageSize;
+            last = std::min(last, (dirty.to + PageSize - 1) / PageSize);
+        }
+
+        for (size_t i = first; i < last; i++) {
+            kv.write(key.pageKey(uint16_t(i)), data + i * PageSize, std::min(PageSize, size - i * PageSize));
+        }
+
+        // Write size last, to not expose incomplete pages set on power loss
+        if (!state.has_size || state.size != size) kv.write(key, reinterpret_cast<uint8_t*>(&size), sizeof(size));
+
+        // Drop pages beyond the new size, after size record stops using them
+        if (state.has_size && key.fitsPages(pagesCount(state.size))) {
+            for (size_t i = pagesCount(size); i < pagesCount(state.size); i++) kv.remove(key.pageKey(uint16_t(i)));
+        }
+
+        state.has_size = true;
+        state.size = size;
+    }
+
+    static bool load(IAsyncPreferenceKV& kv, const PreferenceKey& key, T& value) {
+        State state;
+        return load(kv, key, value, state);
+    }
+
+    static bool load(IAsyncPreferenceKV& kv, const PreferenceKey& key, T& value, State& state) {
+        const size_t head_size = kv.length(key);
+        state = State{};
+        state.known = true;
+
+        if (head_size == 0) return false; // Key not exists => nothing to load
+
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            // Legacy format, whole value under base key
+            if (head_size == sizeof(T) && sizeof(T) != sizeof(uint32_t)) {
+                kv.read(key, reinterpret_cast<uint8_t*>(&value), sizeof(T));
+                return true;
+            }
+        }
+
+        if (head_size != sizeof(uint32_t)) return false; // Broken data, ignore it
+
+        uint32_t size = 0;
+        kv.read(key, reinterpret_cast<uint8_t*>(&size), sizeof(size));
+        // Remember size even for broken pages, to clean up on rewrite
+        state.has_size = true;
+        state.size = size;
+
+        // Validate size & all pages before touching value
+        if constexpr (std::is_trivially_copyable_v<T>) {
+            if (size != sizeof(T)) return false;
+        } else {
+            using Item = typename T::value_type;
+            if (size % sizeof(Item) != 0 || size / sizeof(Item) > value.max_size()) return false;
+        }
+
+        if (!key.fitsPages(pagesCount(size))) return false;
+
+        for (size_t i = 0; i < pagesCount(size); i++) {
+            if (kv.length(key.pageKey(uint16_t(i))) != std::min(PageSize, size - i * PageSize)) return false;
+        }
+
+        if constexpr (!std::is_trivially_copyable_v<T>) {
+            value.resize(size / sizeof(typename T::value_type));
+        }
+
+        uint8_t* data = const_cast<uint8_t*>(bytes(value));
+        for (size_t i = 0; i < pagesCount(size); i++) {
+            kv.read(key.pageKey(uint16_t(i)), data + i * PageSize, std::min(PageSize, size - i * PageSize));
+        }
+        return true;
     }
 
-    static void load(IAsyncPreferenceKV& kv, const std::string& ns, const std::string& key, T& value) {
-        size_t size = kv.length(ns, key);
+private:
+    static size_t pagesCount(size_t size) { return pagesOf(size); }
+
+    // Size record of value, without pages check
+    static void readSize(IAsyncPreferenceKV& kv, const PreferenceKey& key, State& state) {
+        state.known = true;
+        state.has_size = kv.length(key) == sizeof(state.size);
+        state.size = 0;
+        if (state.has_size) kv.read(key, reinterpret_cast<uint8_t*>(&state.size), sizeof(state.size));
+    }
 
-        if (size == 0) return; // Key not exists => nothing to load
-        if (size % sizeof(typename T::value_type) != 0) return; // Wrong size => broken data, ignore it
+    static const uint8_t* bytes(const T& value) {
+        if constexpr (std::is_trivially_copyable_v<T>) return reinterpret_cast<const uint8_t*>(&value);
+        else return reinterpret_cast<const uint8_t*>(value.data());
+    }
 
-        value.resize(size / sizeof(typename T::value_type));
-        kv.read(ns, key, reinterpret_cast<uint8_t*>(value.data()), size);
+    static size_t bytesSize(const T& value) {
+        if constexpr (std::is_trivially_copyable_v<T>) return sizeof(T);
+        else return value.size() * sizeof(typename T::value_type);
     }
 };
 
@@ -60,52 +311,352 @@ struct HasBufferTraits : std::false_type {};
 template <typename T>
 struct HasBufferTraits<T, std::void_t<decltype(std::declval<T>().data()),
                                       decltype(std::declval<T>().size()),
+                                      decltype(std::declval<T>().max_size()),
                                       decltype(std::declval<T>().resize(0))>> : std::true_type {};
 
-// Helper template to trigger static_assert with a dependent type
+// Pick default serializer, if custom one not provided
+template <typename T, typename Custom>
+struct SerializerSelector {
+    using type = Custom;
+};
+
 template <typename T>
-struct dependent_false : std::false_type {};
+struct SerializerSelector<T, void> {
+    using type = std::conditional_t<HasBufferTraits<T>::value, BufferSerializer<T>,
+                 std::conditional_t<std::is_trivially_copyable_v<T>, TrivialSerializer<T>, void>>;
+};
+
+// Serializer with `State` keeps it in preference, and accepts dirty range of
+// snapshot: `save(kv, key, value, dirty, state)`, `load(kv, key, value, state)`
+template <typename S, typename = void>
+struct SerializerState {
+    struct type {};
+    static constexpr bool exists = false;
+};
+
+template <typename S>
+struct SerializerState<S, std::void_t<typename S::State>> {
+    using type = typename S::State;
+    static constexpr bool exists = true;
+};
+
+}
+
+// Persistence counters of single preference. Updated from writer thread,
+// readers get approximate values (fields are not synchronized together).
+struct AsyncPreferenceStats {
+    // Write latency histogram, in us (see `log2_bucket()`)
+    static constexpr size_t LATENCY_BUCKETS = 20;
+
+    uint32_t snapshots = 0; // Successful snapshots (changes detected)
+    uint32_t torn = 0;      // Snapshots skipped due to concurrent update
+    uint32_t writes = 0;    // Storage write calls
+    uint32_t bytes = 0;     // Bytes passed to storage
+    uint32_t latency_max_us = 0;
+    uint32_t latency_total_us = 0;
+    uint32_t latency_histogram[LATENCY_BUCKETS] = {};
+
+    uint32_t latencyAvg() const { return writes ? latency_total_us / writes : 0; }
+
+    static constexpr size_t latencyBucket(uint32_t us) { return log2_bucket(us, LATENCY_BUCKETS); }
+};
+
+// Stats policy without counters, preference pays no RAM for stats
+struct AsyncPreferenceNoStats {};
+
+// Stats are ~100 bytes per preference. Build with
+// `-D ASYNC_PREFERENCE_STATS=0` to drop them by default, or pass stats
+// policy to `AsyncPreference` explicitly.
+#ifndef ASYNC_PREFERENCE_STATS
+#define ASYNC_PREFERENCE_STATS 1
+#endif
+
+using AsyncPreferenceDefaultStats = std::conditional_t<ASYNC_PREFERENCE_STATS, AsyncPreferenceStats, AsyncPreferenceNoStats>;
+
+namespace async_preference_ns {
+
+// Stats storage of preference. Empty for disabled stats, and used as base
+// class to take no space then.
+template <typename Stats>
+struct StatsHolder {
+    Stats stats;
+    uint32_t (*get_time_us)() = nullptr;
+};
+
+template <>
+struct StatsHolder<AsyncPreferenceNoStats> {};
+
+// Storage decorator, collecting write stats of preference
+class StatsKV : public IAsyncPreferenceKV {
+public:
+    StatsKV(IAsyncPreferenceKV& kv, AsyncPreferenceStats& stats, uint32_t (*get_time_us)())
+        : kv(kv), stats(stats), get_time_us(get_time_us) {}
+
+    void write(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+        const uint32_t start = get_time_us ? get_time_us() : 0;
+        kv.write(key, buffer, length);
+
+        stats.writes++;
+        stats.bytes += length;
+
+        if (!get_time_us) return;
+        const uint32_t latency = get_time_us() - start;
+        stats.latency_total_us += latency;
+        stats.latency_max_us = std::max(stats.latency_max_us, latency);
+        stats.latency_histogram[AsyncPreferenceStats::latencyBucket(latency)]++;
+    }
+
+    void read(const PreferenceKey& key, uint8_t* buffer, size_t length) override { kv.read(key, buffer, length); }
+    size_t length(const PreferenceKey& key) override { return kv.length(key); }
+    void remove(const PreferenceKey& key) override { kv.remove(key); }
+
+private:
+    IAsyncPreferenceKV& kv;
+    AsyncPreferenceStats& stats;
+    uint32_t (*get_time_us)();
+};
 
 }
 
 // Internal interface for AsyncPreference
 class AsyncPreferenceTickable {
 public:
+    using StatsVisitor = std::function<void(const PreferenceKey&, const AsyncPreferenceStats&)>;
+
     virtual void tick() = 0;
+
+    // Pass changes to storage, but delay subscribers notification until the
+    // next `tick()`. Used by `flush()`, which can run in any thread.
+    virtual void save() { tick(); }
+
+    // Load value from storage. Namespace is used to group loads.
+    virtual void preload() {}
+    virtual const char* ns() const { return nullptr; }
+
+    // True if value has changes, not passed to storage yet
+    virtual bool hasPending() const { return false; }
+
+    // Called on value change, to wake sleeping writer
+    virtual void setWakeHandler(void (*handler)()) { (void)handler; }
+
+    // Stats support. Clock (in microseconds) is needed for write latencies.
+    virtual void setStatsClock(uint32_t (*get_time_us)()) { (void)get_time_us; }
+    virtual void visitStats(const StatsVisitor& visitor) const { (void)visitor; }
 };
 
 // Writer for asynchronous preferences
 class AsyncPreferenceWriter {
 public:
-    AsyncPreferenceWriter(uint32_t ms_period = 200, uint32_t (*get_time)() = nullptr)
-        : ms_period(ms_period), get_time(get_time), prev_run_ts(0) {}
+    static constexpr uint32_t NEVER = UINT32_MAX;
+
+    // `get_time_us` is optional, to collect write latencies in stats
+    AsyncPreferenceWriter(uint32_t ms_period = 200, uint32_t (*get_time)() = nullptr, uint32_t (*get_time_us)() = nullptr)
+        : ms_period(ms_period), get_time(get_time), get_time_us(get_time_us), prev_run_ts(0), flush_requested(false) {}
+
+    // Safe to call while writer task runs
+    void add(AsyncPreferenceTickable& pref) {
+        std::lock_guard<std::timed_mutex> lock(tick_mutex);
+        pref.setStatsClock(get_time_us);
+        pref.setWakeHandler(wake_handler);
+        preferences.push_back(&pref);
+    }
 
-    void add(AsyncPreferenceTickable& pref) { preferences.push_back(&pref); }
+    // Called when writer has new work (value changed, flush requested), to
+    // let writer task sleep while idle. Set before preferences are modified.
+    void setWakeHandler(void (*handler)()) {
+        std::lock_guard<std::timed_mutex> lock(tick_mutex);
+        wake_handler = handler;
+        for (auto& pref : preferences) pref->setWakeHandler(handler);
+    }
+
+    // Iterate persistence stats of all registered preferences
+    void visitStats(const AsyncPreferenceTickable::StatsVisitor& visitor) const {
+        for (auto& pref : preferences) pref->visitStats(visitor);
+    }
+
+    // Load all registered preferences in one pass, grouped by namespace, so
+    // storage opens each namespace once. Call at boot, after registration.
+    // Then `get()` of registered preferences works from memory only.
+    // Locked against ticks, because preload resets snapshot state, and that
+    // must not overlap with snapshot creation in writer task.
+    void preload(IAsyncPreferenceKV& kv) {
+        std::lock_guard<std::timed_mutex> lock(tick_mutex);
+
+        std::stable_sort(preferences.begin(), preferences.end(), [](AsyncPreferenceTickable* a, AsyncPreferenceTickable* b) {
+            return std::strcmp(a->ns() ? a->ns() : "", b->ns() ? b->ns() : "") < 0;
+        });
+
+        const char* current_ns = nullptr;
+
+        for (auto& pref : preferences) {
+            const char* ns = pref->ns();
+
+            if (ns && (!current_ns || std::strcmp(ns, current_ns) != 0)) {
+                if (current_ns) kv.batchEnd();
+                kv.batchBegin(ns);
+                current_ns = ns;
+            }
+
+            pref->preload();
+        }
+
+        if (current_ns) kv.batchEnd();
+    }
+
+    // Returns delay (ms) until the next tick is needed, or NEVER when all
+    // changes are saved. Writer should be woken by wake handler then.
+    uint32_t tick() {
+        // Requested flush ignores period
+        if (flush_requested.exchange(false)) {
+            const bool ok = flush(flush_timeout);
+            // Already in writer thread, notify subscribers now
+            {
+                std::lock_guard<std::timed_mutex> lock(tick_mutex);
+                tickPreferences();
+            }
+
+            std::vector<std::function<void(bool)>> callbacks;
+            {
+                std::lock_guard<std::mutex> lock(flush_callbacks_mutex);
+                callbacks.swap(flush_callbacks);
+            }
+            for (auto& callback : callbacks) callback(ok);
+
+            std::lock_guard<std::timed_mutex> lock(tick_mutex);
+            return nextDelay();
+        }
 
-    void tick() {
         if (get_time) {
             uint32_t timestamp = get_time();
             if (timestamp < prev_run_ts) prev_run_ts = timestamp; // Handle overflow
-            if (timestamp - prev_run_ts < ms_period) return;
+            if (timestamp - prev_run_ts < ms_period) return ms_period - (timestamp - prev_run_ts);
             prev_run_ts = timestamp;
         }
 
-        for (auto& pref : preferences) pref->tick();
+        std::lock_guard<std::timed_mutex> lock(tick_mutex);
+        tickPreferences();
+        return nextDelay();
+    }
+
+    bool hasPending() const {
+        for (auto& pref : preferences) {
+            if (pref->hasPending()) return true;
+        }
+        return false;
+    }
+
+    // Write all pending changes now, from the caller's thread. Snapshot can
+    // fail if value is being modified, so retry until timeout. Without clock
+    // every attempt is counted as 1 ms. Returns false on timeout.
+    // Subscribers are not called here, but from the next writer tick.
+    //
+    // Lock wait is limited by the same timeout. Flush from inside of writer
+    // tick (subscriber or storage callback calls `esp_restart()`) fails
+    // right away instead of deadlock.
+    bool flush(uint32_t timeout_ms = 1000) {
+        // Relock from the same thread is UB for std mutexes, fail right away
+        if (tick_owner.load() == std::this_thread::get_id()) return false;
+
+        std::unique_lock<std::timed_mutex> lock(tick_mutex, std::defer_lock);
+        if (!lock.try_lock_for(std::chrono::milliseconds(timeout_ms))) return false;
+
+        const uint32_t start = get_time ? get_time() : 0;
+        uint32_t attempts = 0;
+
+        while (true) {
+            for (auto& pref : preferences) pref->save();
+            if (!hasPending()) {
+                // Let writer tick deliver notifications
+                wake();
+                return true;
+            }
+
+            const uint32_t elapsed = get_time ? get_time() - start : ++attempts;
+            if (elapsed >= timeout_ms) {
+                wake();
+                return false;
+            }
+
+            // Sleep instead of yield, to let preempted lower-priority
+            // writer finish value update.
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+
+    // Ask writer thread to flush on the next tick, regardless of period.
+    // Callback is called from writer thread with flush result.
+    void flushAsync(std::function<void(bool)> callback = nullptr, uint32_t timeout_ms = 1000) {
+        if (callback) {
+            std::lock_guard<std::mutex> lock(flush_callbacks_mutex);
+            flush_callbacks.push_back(std::move(callback));
+        }
+        flush_timeout = timeout_ms;
+        flush_requested = true;
+        wake();
+    }
+
+    // Hooks to run before final flush on controlled reset (restart, OTA).
+    // Use to store volatile state, kept out of preferences during work.
+    void addShutdownHook(void (*hook)()) { shutdown_hooks.push_back(hook); }
+
+    // Returns false if flush failed. Called from inside writer tick, flush
+    // is skipped after timeout (see `flush()`).
+    bool shutdown(uint32_t timeout_ms = 1000) {
+        for (auto& hook : shutdown_hooks) hook();
+        return flush(timeout_ms);
     }
 
 private:
+    void wake() { if (wake_handler) wake_handler(); }
+
+    // Call with tick_mutex locked. Owner is remembered to detect flush
+    // from inside of preference tick.
+    void tickPreferences() {
+        tick_owner = std::this_thread::get_id();
+        for (auto& pref : preferences) pref->tick();
+        tick_owner = std::thread::id();
+    }
+
+    // Unsaved changes (incl. torn snapshots) are retried after period
+    uint32_t nextDelay() const { return hasPending() ? ms_period : NEVER; }
+
     uint32_t ms_period;
+    void (*wake_handler)() = nullptr;
     uint32_t (*get_time)();
+    uint32_t (*get_time_us)();
     uint32_t prev_run_ts;
     std::vector<AsyncPreferenceTickable*> preferences;
+
+    // Serializes periodic ticks with flushes from other threads. Timed, to
+    // limit flush wait.
+    std::timed_mutex tick_mutex;
+    std::atomic<std::thread::id> tick_owner{};
+
+    std::atomic<bool> flush_requested;
+    std::atomic<uint32_t> flush_timeout{1000};
+    std::mutex flush_callbacks_mutex;
+    std::vector<std::function<void(bool)>> flush_callbacks;
+
+    std::vector<void (*)()> shutdown_hooks;
 };
 
-template <typename T, typename Serializer = void>
-class AsyncPreference : public AsyncPreferenceTickable {
+template <typename T, typename Serializer = void, typename Stats = AsyncPreferenceDefaultStats>
+class AsyncPreference : public AsyncPreferenceTickable, private async_preference_ns::StatsHolder<Stats> {
 public:
-    AsyncPreference(IAsyncPreferenceKV& kv, const std::string& ns, const std::string& key, T initial = T()) :
-        databox{initial}, kv{kv}, ns(ns), key(key), is_preloaded(false) {}
+    static constexpr bool HAS_STATS = !std::is_same_v<Stats, AsyncPreferenceNoStats>;
+
+    AsyncPreference(IAsyncPreferenceKV& kv, const PreferenceKey& key, T initial = T()) :
+        databox{initial}, kv{kv}, key(key), is_preloaded(false) {
+        // Storage content is unknown until preload, so the first snapshot
+        // should be saved completely.
+        databox.markAllDirty();
+    }
+
+    AsyncPreference(IAsyncPreferenceKV& kv, const char* ns, const char* key, T initial = T()) :
+        AsyncPreference(kv, PreferenceKey(ns, key), initial) {}
 
+    // Returns value from memory. If preference was not preloaded by writer,
+    // the first call loads it from storage.
     T& get() {
         preload();
         return databox.value;
@@ -117,6 +668,12 @@ public:
         valueUpdateEnd();
     }
 
+    void set(T&& value) {
+        valueUpdateBegin();
+        databox.value = std::move(value);
+        valueUpdateEnd();
+    }
+
     // Those are public for case, when user wish to modify complex object
     // internals instead of .set() method. Not recommended for direct use.
     void valueUpdateBegin() {
@@ -127,61 +684,118 @@ public:
 
         databox.beginWrite();
     }
-    void valueUpdateEnd() { databox.endWrite(); }
+    void valueUpdateEnd() {
+        databox.endWrite();
+        if (wake_handler) wake_handler();
+    }
+
+    // Subscriber is called from writer thread only (`tick()`), after value
+    // change is saved, with consistent copy of value. Changes saved by
+    // `flush()` from other threads are notified on the next writer tick.
+    // Keep it short. Never modify state, owned by another task, directly -
+    // hand value over (queue, triple buffer) and wake that task instead.
+    // Subscribe before writer start.
+    using Subscriber = void (*)(const T& value, void* ctx);
+
+    void subscribe(Subscriber fn, void* ctx = nullptr) { subscribers.push_back({ fn, ctx }); }
 
     //
     // Those are for calling by AsyncPreferenceWriter from another thread,
     // to avoid freezes.
     //
     void tick() override {
-        using namespace async_preference_ns;
-
-        if (!databox.makeSnapshot()) return;
-
-        // Save snapshot to storage
-        if constexpr (!std::is_void_v<Serializer>) {
-            // If custom serializer is provided, use it
-            Serializer::save(kv, ns, key, databox.snapshot);
-        } else if constexpr (HasBufferTraits<T>::value) {
-            // Use BufferSerializer if type has buffer-like traits
-            BufferSerializer<T>::save(kv, ns, key, databox.snapshot);
-        } else if constexpr (std::is_trivially_copyable_v<T>) {
-            // Use TrivialSerializer for trivially copyable types
-            TrivialSerializer<T>::save(kv, ns, key, databox.snapshot);
+        save();
+
+        // Updates between ticks are coalesced into one notification
+        if (!notify_pending) return;
+        notify_pending = false;
+        for (auto& subscriber : subscribers) subscriber.fn(databox.snapshot, subscriber.ctx);
+    }
+
+    void save() override {
+        const bool changed = databox.hasChanges();
+
+        if (!databox.makeSnapshot()) {
+            if constexpr (HAS_STATS) { if (changed) this->stats.torn++; }
+            return;
+        }
+
+        if constexpr (HAS_STATS) {
+            this->stats.snapshots++;
+
+            // Save snapshot to storage, counting writes
+            async_preference_ns::StatsKV stats_kv(kv, this->stats, this->get_time_us);
+            store(stats_kv);
         } else {
-            static_assert(dependent_false<T>::value, "No suitable serializer found for this type");
+            (void)changed;
+            store(kv);
         }
-    }
 
-private:
-    DataGuard<T> databox;
-    IAsyncPreferenceKV& kv;
-    std::string ns;
-    std::string key;
-    bool is_preloaded;
+        if (!databox.dirty.empty() && !subscribers.empty()) notify_pending = true;
+    }
 
     // Fetch value from storage, if key exists. This is called only once in
     // life cycle. The next reads are always from memory only.
-    void preload() {
-        using namespace async_preference_ns;
-
+    void preload() override {
         if (is_preloaded) return;
+        is_preloaded = true;
 
-        if (kv.length(ns, key) == 0) return; // If key does not exist
-
-        if constexpr (!std::is_void_v<Serializer>) {
-            // Use custom serializer if provided
-            Serializer::load(kv, ns, key, databox.value);
-        } else if constexpr (HasBufferTraits<T>::value) {
-            // Use BufferSerializer if type has buffer-like traits
-            BufferSerializer<T>::load(kv, ns, key, databox.value);
-        } else if constexpr (std::is_trivially_copyable_v<T>) {
-            // Use TrivialSerializer for trivially copyable types
-            TrivialSerializer<T>::load(kv, ns, key, databox.value);
+        bool loaded;
+        if constexpr (async_preference_ns::SerializerState<SerializerType>::exists) {
+            loaded = SerializerType::load(kv, key, databox.value, serializer_state);
         } else {
-            static_assert(dependent_false<T>::value, "No suitable serializer found for this type");
+            loaded = SerializerType::load(kv, key, databox.value);
         }
 
-        is_preloaded = true;
+        // Storage now matches value, so the next snapshot needs only changes.
+        // Otherwise (missing or broken data) keep all dirty, to rewrite it.
+        if (loaded) databox.syncSnapshot();
+    }
+
+    const char* ns() const override { return key.ns; }
+
+    bool hasPending() const override { return databox.hasChanges(); }
+
+    void setWakeHandler(void (*handler)()) override { wake_handler = handler; }
+    void setStatsClock(uint32_t (*clock)()) override {
+        if constexpr (HAS_STATS) this->get_time_us = clock;
+        else (void)clock;
+    }
+
+    // Preferences without stats are skipped
+    void visitStats(const StatsVisitor& visitor) const override {
+        if constexpr (HAS_STATS) visitor(key, this->stats);
+        else (void)visitor;
     }
+
+    const Stats& getStats() const { return this->stats; }
+
+private:
+    void store(IAsyncPreferenceKV& storage) {
+        if constexpr (async_preference_ns::SerializerState<SerializerType>::exists) {
+            SerializerType::save(storage, key, databox.snapshot, databox.dirty, serializer_state);
+        } else {
+            SerializerType::save(storage, key, databox.snapshot);
+        }
+    }
+
+    // Custom serializer if provided, or default one for buffer-like
+    // and trivially copyable types.
+    using SerializerType = typename async_preference_ns::SerializerSelector<T, Serializer>::type;
+    static_assert(!std::is_void_v<SerializerType>, "No suitable serializer found for this type");
+
+    DataGuard<T> databox;
+    IAsyncPreferenceKV& kv;
+    PreferenceKey key;
+    bool is_preloaded;
+    typename async_preference_ns::SerializerState<SerializerType>::type serializer_state;
+
+    struct SubscriberEntry {
+        Subscriber fn;
+        void* ctx;
+    };
+    std::vector<SubscriberEntry> subscribers;
+    // Snapshot has changes, not notified yet. Access is serialized by writer.
+    bool notify_pending = false;
+    void (*wake_handler)() = nullptr;
 };
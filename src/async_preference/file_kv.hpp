@@ -0,0 +1,403 @@
+#pragma once
+
+// Log-structured, file-backed key-value storage for `native` environment.
+//
+// Every write appends a CRC-protected record to the end of file, and the
+// in-memory index points to the latest record of each key. On open, the log
+// is replayed to rebuild the index, and the tail is truncated at the first
+// broken record (crash recovery). Removal appends a tombstone record.
+// Obsolete records and tombstones are dropped by compaction,
+// which is triggered from `tick()` - register storage in
+// `AsyncPreferenceWriter` to run it in background.
+//
+// Intended for host simulation and soak tests, to model flash wear and
+// persistence throughput. Not used on device.
+//
+// I/O failures don't throw. Failed write leaves index unchanged (and log
+// is truncated back to the last good record), failed read leaves buffer
+// untouched. Both are counted in `Stats::io_errors`.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <filesystem>
+#include <system_error>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#include "async_preference.hpp"
+
+namespace async_preference_ns {
+
+inline uint32_t crc32(const uint8_t* data, size_t length, uint32_t crc = 0) {
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= data[i];
+        for (int k = 0; k < 8; k++) crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+    }
+    return ~crc;
+}
+
+// Flush stdio buffers and force data to disk
+inline bool sync_file(std::FILE* file) {
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+}
+
+class FileAsyncPreferenceKV : public IAsyncPreferenceKV, public AsyncPreferenceTickable {
+public:
+    struct Stats {
+        uint64_t logical_bytes = 0;  // Value bytes requested to write
+        uint64_t physical_bytes = 0; // Bytes actually written to files, including compaction
+        uint32_t writes = 0;
+        uint32_t compactions = 0;
+        uint32_t recovered_tail_bytes = 0; // Garbage truncated on open
+        uint32_t io_errors = 0; // Failed file operations and rejected writes
+        uint32_t hash_collisions = 0; // Different keys with the same hash
+    };
+
+    // Compaction starts when obsolete data exceeds both `compact_threshold`
+    // and the size of live data.
+    FileAsyncPreferenceKV(const std::string& path, size_t compact_threshold = 4096)
+        : path(path), compact_threshold(compact_threshold), file(nullptr), file_size(0), dead_bytes(0) {
+        open();
+    }
+
+    ~FileAsyncPreferenceKV() { if (file) std::fclose(file); }
+
+    FileAsyncPreferenceKV(const FileAsyncPreferenceKV&) = delete;
+    FileAsyncPreferenceKV& operator=(const FileAsyncPreferenceKV&) = delete;
+
+    // False if log file could not be opened. Then all operations fail.
+    bool isOpen() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return file != nullptr;
+    }
+
+    void write(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!append(key, buffer, length)) stats.io_errors++;
+    }
+
+    void read(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = find(key.hash, keyId(key));
+        if (it == index.end() || !file) return;
+
+        const size_t size = std::min(length, it->second.value_length);
+        if (std::fseek(file, static_cast<long>(it->second.value_offset), SEEK_SET) != 0 ||
+            std::fread(buffer, 1, size, file) != size) {
+            std::clearerr(file);
+            stats.io_errors++;
+        }
+    }
+
+    size_t length(const PreferenceKey& key) override {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        auto it = find(key.hash, keyId(key));
+        return it == index.end() ? 0 : it->second.value_length;
+    }
+
+    void remove(const PreferenceKey& key) override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!erase(key)) stats.io_errors++;
+    }
+
+    // Background maintenance, called by AsyncPreferenceWriter
+    void tick() override {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (dead_bytes > compact_threshold && dead_bytes > file_size - dead_bytes) {
+            if (!compactUnlocked()) stats.io_errors++;
+        }
+    }
+
+    // Returns false on failure, old log is kept then
+    bool compact() {
+        std::lock_guard<std::mutex> lock(mutex);
+        const bool ok = compactUnlocked();
+        if (!ok) stats.io_errors++;
+        return ok;
+    }
+
+    Stats getStats() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+
+    size_t fileSize() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return file_size;
+    }
+
+private:
+    // Record layout (little-endian host assumed):
+    //   crc32 (4) | magic (2) | ns_len (1) | key_len (1) | value_len (4) | ns | key | value
+    // CRC covers everything after crc field. Tombstone has own magic and
+    // no value.
+    static constexpr size_t HEAD_SIZE = 12;
+    static constexpr uint16_t MAGIC = 0x4B56;
+    static constexpr uint16_t TOMBSTONE = 0x4B44;
+    // Limited by 1-byte length fields
+    static constexpr size_t MAX_NAME_LENGTH = 255;
+
+    struct Entry {
+        size_t value_offset;
+        size_t value_length;
+        size_t record_size;
+        std::string id; // ns + '\0' + full name, to resolve hash collisions
+    };
+    using Index = std::unordered_multimap<uint32_t, Entry>;
+
+    std::string path;
+    size_t compact_threshold;
+    std::FILE* file;
+    size_t file_size;
+    size_t dead_bytes;
+    Stats stats;
+    std::mutex mutex;
+    Index index; // key hash => latest record of each key
+
+    // Returns false if names don't fit into record
+    static bool makeRecord(const PreferenceKey& key, const uint8_t* buffer, size_t length, std::vector<uint8_t>& record, uint16_t magic = MAGIC) {
+        char name[MAX_NAME_LENGTH + 1];
+        if (!key.fullName(name, sizeof(name))) return false;
+
+        const size_t ns_len = std::strlen(key.ns);
+        const size_t name_len = std::strlen(name);
+        if (ns_len > MAX_NAME_LENGTH || name_len > MAX_NAME_LENGTH) return false;
+
+        record.assign(HEAD_SIZE + ns_len + name_len + length, 0);
+        const uint32_t value_len = static_cast<uint32_t>(length);
+
+        std::memcpy(&record[4], &magic, 2);
+        record[6] = static_cast<uint8_t>(ns_len);
+        record[7] = static_cast<uint8_t>(name_len);
+        std::memcpy(&record[8], &value_len, 4);
+        std::memcpy(&record[HEAD_SIZE], key.ns, ns_len);
+        std::memcpy(&record[HEAD_SIZE + ns_len], name, name_len);
+        if (length) std::memcpy(&record[HEAD_SIZE + ns_len + name_len], buffer, length);
+
+        const uint32_t crc = async_preference_ns::crc32(&record[4], record.size() - 4);
+        std::memcpy(&record[0], &crc, 4);
+        return true;
+    }
+
+    static std::string keyId(const PreferenceKey& key) {
+        char name[MAX_NAME_LENGTH + 1];
+        key.fullName(name, sizeof(name));
+        return std::string(key.ns) + '\0' + name;
+    }
+
+    Index::iterator find(uint32_t hash, const std::string& id) {
+        auto range = index.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second.id == id) return it;
+        }
+        return index.end();
+    }
+
+    // Replace previous record of the same key, if any. Returns true if new
+    // key collides by hash with another one.
+    bool updateIndex(uint32_t hash, Entry&& entry) {
+        auto it = find(hash, entry.id);
+        if (it != index.end()) {
+            dead_bytes += it->second.record_size;
+            it->second = std::move(entry);
+            return false;
+        }
+
+        const bool collision = index.count(hash) > 0;
+        index.emplace(hash, std::move(entry));
+        return collision;
+    }
+
+    // Write record to the end of log, without index update
+    bool writeRecord(const std::vector<uint8_t>& record) {
+        const bool ok = std::fseek(file, static_cast<long>(file_size), SEEK_SET) == 0 &&
+            std::fwrite(record.data(), 1, record.size(), file) == record.size() &&
+            std::fflush(file) == 0;
+
+        if (!ok) {
+            // Drop partial record, or the next ones would be lost on replay
+            std::clearerr(file);
+            std::error_code ec;
+            std::filesystem::resize_file(path, file_size, ec);
+        }
+        return ok;
+    }
+
+    bool append(const PreferenceKey& key, const uint8_t* buffer, size_t length) {
+        if (!file) return false;
+
+        std::vector<uint8_t> record;
+        if (!makeRecord(key, buffer, length, record)) return false;
+        if (!writeRecord(record)) return false;
+
+        if (updateIndex(key.hash, { file_size + record.size() - length, length, record.size(), keyId(key) })) {
+            stats.hash_collisions++;
+        }
+        file_size += record.size();
+
+        stats.logical_bytes += length;
+        stats.physical_bytes += record.size();
+        stats.writes++;
+        return true;
+    }
+
+    // Missing key is not an error, nothing to write then
+    bool erase(const PreferenceKey& key) {
+        auto it = find(key.hash, keyId(key));
+        if (it == index.end()) return true;
+        if (!file) return false;
+
+        std::vector<uint8_t> record;
+        if (!makeRecord(key, nullptr, 0, record, TOMBSTONE)) return false;
+        if (!writeRecord(record)) return false;
+
+        // Both old record & tombstone are garbage for compaction
+        dead_bytes += it->second.record_size + record.size();
+        index.erase(it);
+        file_size += record.size();
+
+        stats.physical_bytes += record.size();
+        stats.writes++;
+        return true;
+    }
+
+    bool open() {
+        index.clear();
+        file_size = 0;
+        dead_bytes = 0;
+
+        file = std::fopen(path.c_str(), "r+b");
+        if (!file) file = std::fopen(path.c_str(), "w+b");
+        if (!file) {
+            stats.io_errors++;
+            return false;
+        }
+
+        std::fseek(file, 0, SEEK_END);
+        const long end = std::ftell(file);
+        std::fseek(file, 0, SEEK_SET);
+        const size_t real_size = end > 0 ? static_cast<size_t>(end) : 0;
+
+        // Replay log & stop at first broken record
+        std::vector<uint8_t> record;
+        while (true) {
+            uint8_t head[HEAD_SIZE];
+            if (std::fread(head, 1, HEAD_SIZE, file) != HEAD_SIZE) break;
+
+            uint32_t crc, value_len;
+            uint16_t magic;
+            std::memcpy(&crc, &head[0], 4);
+            std::memcpy(&magic, &head[4], 2);
+            std::memcpy(&value_len, &head[8], 4);
+            if (magic != MAGIC && magic != TOMBSTONE) break;
+
+            const size_t payload_size = size_t(head[6]) + head[7] + value_len;
+            if (file_size + HEAD_SIZE + payload_size > real_size) break;
+
+            record.assign(head, head + HEAD_SIZE);
+            record.resize(HEAD_SIZE + payload_size);
+            if (std::fread(&record[HEAD_SIZE], 1, payload_size, file) != payload_size) break;
+            if (async_preference_ns::crc32(&record[4], record.size() - 4) != crc) break;
+
+            // Hash selects bucket, names distinguish colliding keys
+            const std::string ns(reinterpret_cast<char*>(&record[HEAD_SIZE]), head[6]);
+            const std::string name(reinterpret_cast<char*>(&record[HEAD_SIZE + head[6]]), head[7]);
+            const uint32_t hash = PreferenceKey::hashOf(ns.c_str(), name.c_str());
+
+            std::string id = ns + '\0' + name;
+
+            if (magic == TOMBSTONE) {
+                auto it = find(hash, id);
+                if (it != index.end()) {
+                    dead_bytes += it->second.record_size;
+                    index.erase(it);
+                }
+                dead_bytes += record.size();
+            } else {
+                updateIndex(hash, { file_size + record.size() - value_len, value_len, record.size(), std::move(id) });
+            }
+            file_size += record.size();
+        }
+
+        // Drop broken tail, if any
+        if (real_size > file_size) {
+            stats.recovered_tail_bytes += static_cast<uint32_t>(real_size - file_size);
+            std::fclose(file);
+            file = nullptr;
+
+            std::error_code ec;
+            std::filesystem::resize_file(path, file_size, ec);
+            if (!ec) file = std::fopen(path.c_str(), "r+b");
+            if (!file) {
+                index.clear();
+                stats.io_errors++;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool compactUnlocked() {
+        if (!file) return false;
+
+        const std::string tmp_path = path + ".tmp";
+        std::FILE* tmp = std::fopen(tmp_path.c_str(), "wb");
+        if (!tmp) return false;
+
+        bool ok = true;
+        size_t written = 0;
+        std::vector<uint8_t> record;
+        for (const auto& item : index) {
+            record.resize(item.second.record_size);
+            ok = std::fseek(file, static_cast<long>(item.second.value_offset + item.second.value_length - item.second.record_size), SEEK_SET) == 0 &&
+                std::fread(record.data(), 1, record.size(), file) == record.size() &&
+                std::fwrite(record.data(), 1, record.size(), tmp) == record.size();
+            if (!ok) break;
+            written += record.size();
+        }
+
+        // New log should be on disk before rename, or crash could leave
+        // renamed but empty file.
+        ok = ok && async_preference_ns::sync_file(tmp);
+        ok = (std::fclose(tmp) == 0) && ok;
+
+        if (!ok) {
+            std::clearerr(file);
+            std::remove(tmp_path.c_str());
+            return false;
+        }
+
+        std::fclose(file);
+        file = nullptr;
+
+        // Rename is atomic, so crash leaves either old or new log intact
+        std::error_code ec;
+        std::filesystem::rename(tmp_path, path, ec);
+        if (ec) std::remove(tmp_path.c_str());
+        else {
+            stats.physical_bytes += written;
+            stats.compactions++;
+        }
+
+        // Reopen either new or old log
+        return open() && !ec;
+    }
+};
@@ -1,14 +1,34 @@
 #include <Arduino.h>
+#include <esp_system.h>
 #include "prefs.hpp"
 
 AsyncPreferenceKV prefsKV;
-AsyncPreferenceWriter prefsWriter(200, []() { return millis(); });
+AsyncPreferenceWriter prefsWriter(200, []() { return millis(); }, []() { return micros(); });
+
+namespace {
+
+TaskHandle_t prefs_task = nullptr;
+
+void prefs_thread(void* pvParameters) {
+    while (true) {
+        const uint32_t delay = prefsWriter.tick();
+
+        // Sleep while all changes are saved, value updates wake writer up
+        ulTaskNotifyTake(pdTRUE, delay == AsyncPreferenceWriter::NEVER ? portMAX_DELAY : pdMS_TO_TICKS(delay));
+    }
+}
+
+}
 
 void prefs_init() {
-    xTaskCreate([](void*) {
-        while(true) {
-            prefsWriter.tick();
-            vTaskDelay(pdMS_TO_TICKS(100));
-        }
-    }, "prefs", 1024*4, NULL, 1, NULL);
+    // Flush pending changes on `esp_restart()` (OTA, manual reboot). Brownout
+    // resets the chip without handlers, and flash write is not safe at low
+    // voltage anyway - only controlled resets are covered.
+    esp_register_shutdown_handler([]() { prefsWriter.shutdown(500); });
+
+    prefsWriter.setWakeHandler([]() { if (prefs_task) xTaskNotifyGive(prefs_task); });
+
+    // Own task, below scheduler priority. NVS write can take tens of ms (page
+    // erase), and should not delay button & blinker ticks.
+    xTaskCreate(prefs_thread, "prefs", 1024 * 4, NULL, 1, &prefs_task);
 }
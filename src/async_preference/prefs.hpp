@@ -1,32 +1,91 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+#include <mutex>
 #include "Preferences.h"
 #include "async_preference.hpp"
+#include "logger.hpp"
 
 class AsyncPreferenceKV : public IAsyncPreferenceKV {
     Preferences prefs;
+    char name[PreferenceKey::MAX_NAME_LENGTH + 1];
+    // Shared by writer task & readers. Recursive, because batch keeps it
+    // locked between calls.
+    std::recursive_mutex mutex;
+    const char* batch_ns = nullptr;
 
-    void write(const std::string& ns, const std::string& key, uint8_t* buffer, size_t length) override {
-        prefs.begin(ns.c_str(), false);
-        prefs.putBytes(key.c_str(), buffer, length);
-        prefs.end();
+    // Truncated name could match another key, so such keys are rejected
+    bool makeName(const PreferenceKey& key) {
+        if (key.fullName(name, sizeof(name))) return true;
+        logger.push_error("PREFS: key name too long [{}.{}]", key.ns, key.name);
+        return false;
+    }
+
+    void write(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        if (!makeName(key)) return;
+        open(key.ns, false);
+        prefs.putBytes(name, buffer, length);
+        close(key.ns, false);
+    }
+
+    void read(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        if (!makeName(key)) return;
+        open(key.ns, true);
+        prefs.getBytes(name, buffer, length);
+        close(key.ns, true);
     }
 
-    void read(const std::string& ns, const std::string& key, uint8_t* buffer, size_t length) override {
-        prefs.begin(ns.c_str(), true);
-        prefs.getBytes(key.c_str(), buffer, length);
+    void remove(const PreferenceKey& key) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        if (!makeName(key)) return;
+        open(key.ns, false);
+        if (prefs.isKey(name)) prefs.remove(name);
+        close(key.ns, false);
+    }
+
+    size_t length(const PreferenceKey& key) override {
+        std::lock_guard<std::recursive_mutex> lock(mutex);
+        if (!makeName(key)) return 0;
+        open(key.ns, true);
+        size_t len = prefs.isKey(name) ? prefs.getBytesLength(name) : 0;
+        close(key.ns, true);
+        return len;
+    }
+
+    void batchBegin(const char* ns) override {
+        mutex.lock();
+        prefs.begin(ns, true);
+        batch_ns = ns;
+    }
+
+    void batchEnd() override {
         prefs.end();
+        batch_ns = nullptr;
+        mutex.unlock();
+    }
+
+    // Reads from batch namespace reuse it, anything else temporarily
+    // replaces it (only one namespace can be open).
+    bool reusesBatch(const char* ns, bool readonly) const {
+        return readonly && batch_ns && std::strcmp(batch_ns, ns) == 0;
+    }
+
+    void open(const char* ns, bool readonly) {
+        if (reusesBatch(ns, readonly)) return;
+        if (batch_ns) prefs.end();
+        prefs.begin(ns, readonly);
     }
 
-    size_t length(const std::string& ns, const std::string& key) override {
-        prefs.begin(ns.c_str(), true);
-        size_t len = prefs.isKey(key.c_str()) ? prefs.getBytesLength(key.c_str()) : 0;
+    void close(const char* ns, bool readonly) {
+        if (reusesBatch(ns, readonly)) return;
         prefs.end();
-        return len;
+        if (batch_ns) prefs.begin(batch_ns, true);
     }
 };
 
 extern AsyncPreferenceKV prefsKV;
 extern AsyncPreferenceWriter prefsWriter;
-void prefs_init();
\ No newline at end of file
+void prefs_init();
@@ -3,8 +3,13 @@
 #include "blinker/blinker.h"
 #include "button/button.hpp"
 
-#define BLINK_IDLE_BACKGROUND { 10 }
+// Levels are in lightness space (blinker gamma is on). Dim idle glow keeps
+// the PWM duty it was tuned for, ~4%.
+inline constexpr uint8_t BLINK_IDLE_LEVEL = blinker_curves_ns::lightness(10);
 
-#define BLINK_LONG_PRESS_START { {10, 0}, blinker.flowTo(255, Button::LONG_PRESS_THRESHOLD - Button::SHORT_PRESS_THRESHOLD) }
+#define BLINK_IDLE_BACKGROUND { BLINK_IDLE_LEVEL }
 
-#define BLINK_BONDING_LOOP { {255, 150}, {0, 250} }
+#define BLINK_LONG_PRESS_START { {BLINK_IDLE_LEVEL, 0}, blinker.flowTo(255, button.getTiming().long_press - button.getTiming().short_press) }
+
+// Constant patterns are used in place, without copy to sequence pool
+inline constexpr Blinker::Action BLINK_BONDING_LOOP[] = { {255, 150}, {0, 250} };
@@ -1,14 +1,19 @@
 #include "blinker.h"
+#include "scheduler.hpp"
 
 Blinker blinker;
 
-void blinker_thread(void* pvParameters) {
-    while (true) {
-        blinker.tick(millis());
-        vTaskDelay(pdMS_TO_TICKS(20));
-    }
+namespace {
+
+int blinker_job = -1;
+
 }
 
 void blinker_init() {
-    xTaskCreate(blinker_thread, "blink_thread", 1024 * 4, NULL, 1, NULL);
-}
\ No newline at end of file
+    blinker.setGamma(true);
+
+    // Ticked only at step ends and animation frames. New sequences wake it.
+    static_assert(Blinker::NEVER == Scheduler::NEVER, "Deadline markers should match");
+    blinker_job = scheduler.add([](uint32_t now) { return blinker.tick(now); });
+    blinker.setWakeHandler([]() { scheduler_wake(blinker_job); });
+}
@@ -19,7 +19,14 @@ private:
     bool initialized;
 };
 
-using Blinker = BlinkerEngine<LedDriver>;
+// Animation layers, from bottom to top
+enum BlinkLayer : size_t {
+    BLINK_LAYER_STATUS,   // Long-running state indication (bonding, ...)
+    BLINK_LAYER_FEEDBACK, // Short reactions to user actions
+    BLINK_LAYERS_COUNT
+};
+
+using Blinker = BlinkerEngine<LedDriver, BLINK_LAYERS_COUNT>;
 
 extern Blinker blinker;
 void blinker_init();
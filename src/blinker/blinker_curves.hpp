@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// Easing curves for animated blinker steps
+enum class BlinkerCurve : uint8_t {
+    LINEAR,
+    EASE_IN,     // Quadratic
+    EASE_OUT,    // Quadratic
+    EASE_IN_OUT, // Cubic smoothstep
+    SINE,        // Half cosine wave
+    EXPO,        // Exponential, for "breathing" effects
+    COUNT
+};
+
+namespace blinker_curves_ns {
+
+// Progress is fixed point 0..256 (256 = step end)
+constexpr uint32_t PROGRESS_ONE = 256;
+
+//
+// Compile-time math helpers. Precision is enough for 8-bit tables.
+//
+
+constexpr double CURVE_PI = 3.14159265358979323846;
+
+constexpr double cosine(double x) {
+    // Series for x in [0, pi]
+    double term = 1, sum = 1;
+    for (int i = 1; i < 20; i++) {
+        term *= -x * x / ((2 * i - 1) * (2 * i));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double exponent(double x) {
+    // Series converges badly for negative x, use 1/e^-x
+    const bool negative = x < 0;
+    if (negative) x = -x;
+
+    double term = 1, sum = 1;
+    for (int i = 1; i < 40; i++) {
+        term *= x / i;
+        sum += term;
+    }
+    return negative ? 1 / sum : sum;
+}
+
+constexpr double ease(BlinkerCurve curve, double t) {
+    switch (curve) {
+        case BlinkerCurve::EASE_IN: return t * t;
+        case BlinkerCurve::EASE_OUT: return t * (2 - t);
+        case BlinkerCurve::EASE_IN_OUT: return t * t * (3 - 2 * t);
+        case BlinkerCurve::SINE: return 0.5 - 0.5 * cosine(CURVE_PI * t);
+        // 2^(10t - 10), shifted to start from exact 0
+        case BlinkerCurve::EXPO: return t == 0 ? 0 : (exponent((10 * t - 10) * 0.69314718055994531) - 0.0009765625) / (1 - 0.0009765625);
+        default: return t;
+    }
+}
+
+using CurveTable = std::array<std::array<uint16_t, PROGRESS_ONE + 1>, size_t(BlinkerCurve::COUNT)>;
+
+constexpr CurveTable makeCurves() {
+    CurveTable table{};
+    for (size_t c = 0; c < size_t(BlinkerCurve::COUNT); c++) {
+        for (uint32_t i = 0; i <= PROGRESS_ONE; i++) {
+            const double v = ease(BlinkerCurve(c), double(i) / PROGRESS_ONE) * PROGRESS_ONE;
+            table[c][i] = uint16_t(v < 0 ? 0 : v > PROGRESS_ONE ? PROGRESS_ONE : v + 0.5);
+        }
+    }
+    return table;
+}
+
+// CIE 1931 lightness => PWM duty, so equal steps look equal to eye
+constexpr std::array<uint8_t, 256> makeGamma() {
+    std::array<uint8_t, 256> table{};
+    for (size_t i = 0; i < 256; i++) {
+        const double l = double(i) * 100 / 255;
+        const double y = l <= 8 ? l / 903.3 : ((l + 16) / 116) * ((l + 16) / 116) * ((l + 16) / 116);
+        table[i] = uint8_t(y * 255 + 0.5);
+    }
+    return table;
+}
+
+inline constexpr CurveTable CURVES = makeCurves();
+inline constexpr std::array<uint8_t, 256> GAMMA = makeGamma();
+
+// Inverse of GAMMA: the lowest lightness level with at least `duty` PWM
+// output. To port levels, tuned for linear output, when gamma is on.
+constexpr uint8_t lightness(uint8_t duty) {
+    for (size_t i = 0; i < GAMMA.size(); i++) {
+        if (GAMMA[i] >= duty) return uint8_t(i);
+    }
+    return 255;
+}
+
+// Fixed point reciprocal of step period. Per-tick progress is then
+// `(elapsed * reciprocal) >> 16`, without division.
+inline uint32_t progressReciprocal(uint32_t period) {
+    return period ? ((PROGRESS_ONE << 16) + period - 1) / period : 0;
+}
+
+inline uint32_t progress(uint32_t elapsed, uint32_t period, uint32_t reciprocal) {
+    if (elapsed >= period) return PROGRESS_ONE;
+    const uint32_t p = uint32_t((uint64_t(elapsed) * reciprocal) >> 16);
+    return p < PROGRESS_ONE ? p : PROGRESS_ONE - 1;
+}
+
+// Interpolate 8-bit value by eased progress
+inline uint8_t interpolate(uint8_t from, uint8_t to, uint32_t progress, BlinkerCurve curve) {
+    const int32_t k = CURVES[size_t(curve)][progress];
+    return uint8_t(from + (((int32_t(to) - from) * k) >> 8));
+}
+
+}
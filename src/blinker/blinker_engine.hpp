@@ -1,12 +1,17 @@
 #pragma once
 
 #include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <initializer_list>
 #include <algorithm>
 #include <type_traits>
-#include <atomic>
+#include <vector>
+#include "utils/seqlock.hpp"
+#include "blinker_curves.hpp"
 
+// Frame buffer driver. For pixel strips, channels are pixels * colors.
 template<int Channels>
 class IBlinkerLED {
 public:
@@ -14,178 +19,321 @@ public:
 
     using DataType = typename std::array<uint8_t, Channels>;
 
+    // Output the whole frame in one transfer. Called only when frame
+    // differs from the previous one.
     virtual void set(const DataType& value) = 0;
 };
 
 
-template <typename T>
-class BlinkerSimpleQueue {
-private:
-    T buffer;
-    std::atomic<uint32_t> versionCounter;
-    std::atomic<bool> writerActive;
-    uint32_t lastReadVersion;
-
-public:
-    BlinkerSimpleQueue() : versionCounter(0), writerActive(false), lastReadVersion(0) {}
-
-    bool write(const T& value) {
-        // Disable parallel writes
-        bool expected = false;
-        if (!writerActive.compare_exchange_strong(expected, true)) return false;
-
-        versionCounter.fetch_add(1, std::memory_order_acquire); // Odd => write in progress
-        buffer = value;
-        versionCounter.fetch_add(1, std::memory_order_release); // Even => write completed
-
-        writerActive.store(false, std::memory_order_release);
-        return true;
-    }
-
-    bool read(T& output) {
-        uint32_t versionBefore = versionCounter.load(std::memory_order_acquire);
-
-        if (versionBefore == lastReadVersion) return false; // No new data
+// How layer output is combined with layers below
+enum class BlinkerBlend : uint8_t {
+    OVERRIDE, // Replace
+    MAX,      // Brightest wins
+    ADD       // Sum, saturated
+};
 
-        if (versionBefore % 2 != 0) return false; // Override in progress
+// Step of sequence. Does not depend on layers count, so patterns can be
+// shared between engines with the same driver.
+template<typename Driver>
+struct BlinkerAction {
+    typename Driver::DataType value;
+    uint32_t period;
+    bool isAnimated;
+    BlinkerCurve curve;
 
-        T tempBuffer = buffer;
+    // Constexpr, to define patterns as constant data
+    constexpr BlinkerAction() : value{}, period(0), isAnimated(false), curve(BlinkerCurve::LINEAR) {}
 
-        // Re-read version to make sure data not changed
-        uint32_t versionAfter = versionCounter.load(std::memory_order_acquire);
-        if (versionAfter != versionBefore) return false;
+    constexpr BlinkerAction(typename Driver::DataType value, uint32_t period, bool isAnimated = false,
+        BlinkerCurve curve = BlinkerCurve::LINEAR)
+        : value(value), period(period), isAnimated(isAnimated), curve(curve) {}
 
-        output = tempBuffer;
-        lastReadVersion = versionBefore;
-        return true;
-    }
+    // Sugar for single channel, to omit brackets
+    template<int Channels = Driver::ChannelsCount, typename = std::enable_if_t<Channels == 1>>
+    constexpr BlinkerAction(uint8_t singleValue, uint32_t period, bool isAnimated = false,
+        BlinkerCurve curve = BlinkerCurve::LINEAR)
+        : value{std::array<uint8_t, 1>{singleValue}}, period(period), isAnimated(isAnimated), curve(curve) {}
 };
 
-template<typename Driver>
+// Layers are composed from 0 (bottom, above background) to Layers-1 (top).
+// Each layer runs own sequence, and contributes to output only while
+// sequence is playing.
+template<typename Driver, size_t Layers = 1>
 class BlinkerEngine {
 public:
-    struct Action {
-        typename Driver::DataType value;
-        uint32_t period;
-        bool isAnimated;
+    using Action = BlinkerAction<Driver>;
 
-        Action() : value{}, period(0), isAnimated(false) {}
+    // Slots for published, running and being filled sequences
+    static constexpr size_t POOL_SIZE = Layers * 2 + 2;
 
-        Action(typename Driver::DataType value, uint32_t period, bool isAnimated = false)
-            : value(value), period(period), isAnimated(isAnimated) {}
+    // tick() result when nothing is playing
+    static constexpr uint32_t NEVER = UINT32_MAX;
+    // Redraw period of animated steps, ms
+    static constexpr uint32_t FRAME_PERIOD = 20;
 
-        // Sugar for single channel, to omit brackets
-        template<int Channels = Driver::ChannelsCount, typename = std::enable_if_t<Channels == 1>>
-        Action(uint8_t singleValue, uint32_t period, bool isAnimated = false)
-            : value{std::array<uint8_t, 1>{singleValue}}, period(period), isAnimated(isAnimated) {}
-    };
+    BlinkerEngine() : driver(), backgroundQueue{}, backgroundCursor{}, prevTickTs(0), backgroundValue{}, layers{} {}
+
+    // Blend mode of layer. Set before use, not thread safe.
+    void setBlend(size_t layer, BlinkerBlend mode) { if (layer < Layers) layers[layer].blend = mode; }
+
+    // Called after new sequence or background is published, to run tick()
+    // earlier than it asked. Set before use.
+    void setWakeHandler(void (*handler)()) { wakeHandler = handler; }
+
+    // Sequences of any length, copied into pool slot. Return false if no
+    // free slot (too many concurrent writers).
+    bool loop(const std::initializer_list<Action>& actions, size_t layer = 0) { return updateSequence(layer, actions.begin(), actions.size(), true, true); }
 
-    BlinkerEngine() : driver(), sequenceQueue{}, backgroundQueue{}, prevTickTs(0), hasNewJob(false), working(false),
-        sequence{}, backgroundValue{}, currentActionIdx(0), actionProgress(0), prevActionValue{} {}
+    bool once(const std::initializer_list<Action>& actions, size_t layer = 0) { return updateSequence(layer, actions.begin(), actions.size(), false, true); }
 
-    void loop(const std::initializer_list<Action>& actions) { updateSequence(actions, true); }
+    // Constant patterns (`static constexpr Action PATTERN[] = {...}`) are
+    // referenced in place, without copy. Data must outlive the animation.
+    template <size_t N>
+    bool loop(const Action (&actions)[N], size_t layer = 0) { return updateSequence(layer, actions, N, true, false); }
 
-    void once(const std::initializer_list<Action>& actions) { updateSequence(actions, false); }
+    template <size_t N>
+    bool once(const Action (&actions)[N], size_t layer = 0) { return updateSequence(layer, actions, N, false, false); }
 
     void background(const typename Driver::DataType& value) {
         const typename Driver::DataType val = std::move(value);
         backgroundQueue.write(val);
+        wake();
     }
     // Sugar for single channel, to omit brackets
     template<int Channels = Driver::ChannelsCount, typename = std::enable_if_t<Channels == 1>>
     void background(const uint8_t value) {
         typename Driver::DataType val = {value};
         backgroundQueue.write(val);
+        wake();
     }
 
-    void off() { once({ {backgroundValue, 0} }); }
+    // Stop layer sequence, to show layers below
+    void off(size_t layer = 0) {
+        if (layer >= Layers) return;
+        Slot* replaced = layers[layer].pending.exchange(&stopSlot, std::memory_order_acq_rel);
+        release(replaced);
+        wake();
+    }
 
-    static Action flowTo(const typename Driver::DataType target, uint32_t duration) { return {target, duration, true}; }
+    static constexpr Action flowTo(const typename Driver::DataType target, uint32_t duration,
+        BlinkerCurve curve = BlinkerCurve::LINEAR) { return {target, duration, true, curve}; }
     // Sugar for single channel, to omit brackets
     template<int Channels = Driver::ChannelsCount, typename = std::enable_if_t<Channels == 1>>
-    static Action flowTo(uint8_t target, uint32_t duration) { return {target, duration, true}; }
+    static constexpr Action flowTo(uint8_t target, uint32_t duration,
+        BlinkerCurve curve = BlinkerCurve::LINEAR) { return {target, duration, true, curve}; }
+
+    // Perceptual brightness correction of output. Set before use.
+    void setGamma(bool enable) { gamma = enable; }
 
     static inline const Action OFF = { typename Driver::DataType{}, 0 };
 
-    void tick(uint32_t msTimestamp) {
-        if (prevTickTs == 0) { prevTickTs = msTimestamp; return; }
+    // Returns ms until the next step end or animation frame, or NEVER if
+    // nothing is playing. New sequences call wake handler.
+    uint32_t tick(uint32_t msTimestamp) {
+        if (prevTickTs == 0) prevTickTs = msTimestamp;
 
         uint32_t elapsed = msTimestamp - prevTickTs;
         prevTickTs = msTimestamp;
 
-        if (sequenceQueue.read(sequence)) hasNewJob = true;
+        bool dirty = backgroundQueue.tryRead(backgroundValue, backgroundCursor);
 
-        if (hasNewJob) {
-            currentActionIdx = 0;
-            actionProgress = 0;
-            working = true;
-            hasNewJob = false;
+        for (auto& layer : layers) {
+            const bool shown = tickLayer(layer, elapsed);
+
+            // Started, finished or stopped layer, or new value of shown one
+            if (shown != layer.shown || (shown && layer.updated)) dirty = true;
+            layer.shown = shown;
         }
 
-        if (backgroundQueue.read(backgroundValue) && !working) driver.set(backgroundValue);
+        // Static steps and idle state cost nothing, frame is not rendered
+        if (dirty) render();
+
+        return nextDeadline();
+    }
+
+private:
+    struct Slot {
+        std::atomic<bool> busy{false};
+        std::vector<Action> storage; // Capacity is reused by next sequences
+        const Action* actions = nullptr;
+        size_t length = 0;
+        bool looping = false;
+    };
+
+    struct Layer {
+        std::atomic<Slot*> pending{nullptr};
+        Slot* active = nullptr;
+        BlinkerBlend blend = BlinkerBlend::OVERRIDE;
+        bool working = false;
+        bool shown = false; // Contributed to the last output
+        bool updated = false; // Value changed by the last tick
+        bool stepStarted = false;
+        size_t currentActionIdx = 0;
+        uint32_t actionProgress = 0;
+        uint32_t actionReciprocal = 0; // See blinker_curves_ns::progress()
+        typename Driver::DataType prevActionValue{};
+        typename Driver::DataType value{};
+    };
+
+    void render() {
+        typename Driver::DataType output = backgroundValue;
+        for (auto& layer : layers) {
+            if (layer.shown) blend(output, layer.value, layer.blend);
+        }
 
-        if (working) {
-            const auto& action = sequence.actions[currentActionIdx];
-            actionProgress = std::min(actionProgress + elapsed, action.period);
+        // Rendered the same (slow animation, layers composed to the same
+        // result), skip transfer
+        if (output == frame) return;
+        frame = output;
 
-            // Calculate & set led value
-            if (action.isAnimated) {
-                typename Driver::DataType value;
-                for (int i = 0; i < Driver::ChannelsCount; i++) {
-                    int32_t from = prevActionValue[i];
-                    int32_t to = action.value[i];
-                    int32_t val = from + (to - from) * int32_t(actionProgress) / int32_t(action.period);
-                    value[i] = val < 0 ? 0 : val > 255 ? 255 : val;
+        if (gamma) {
+            for (auto& v : output) v = blinker_curves_ns::GAMMA[v];
+        }
+        driver.set(output);
+    }
+
+    uint32_t nextDeadline() const {
+        uint32_t next = NEVER;
+        for (const auto& layer : layers) {
+            if (!layer.working) continue;
+
+            const auto& action = layer.active->actions[layer.currentActionIdx];
+            uint32_t left = action.period - layer.actionProgress;
+            if (action.isAnimated) left = std::min(left, FRAME_PERIOD);
+            // Looping zero-length steps, don't spin on them
+            if (!left) left = FRAME_PERIOD;
+            next = std::min(next, left);
+        }
+        return next;
+    }
+
+    // Advance layer sequence. Returns false if layer has no output.
+    bool tickLayer(Layer& layer, uint32_t elapsed) {
+        // Take the latest published sequence, and return the old one to pool.
+        // New sequence starts now, time before pickup does not count.
+        Slot* published = layer.pending.exchange(nullptr, std::memory_order_acquire);
+        if (published) {
+            release(layer.active);
+            layer.active = published == &stopSlot ? nullptr : published;
+            layer.working = layer.active != nullptr;
+            if (layer.working) startAction(layer, 0);
+            elapsed = 0;
+        }
+
+        if (!layer.working) return false;
+
+        // Skip finished steps, carrying the rest of time to the next ones.
+        // Zero-length steps only set start value of the next animation.
+        layer.actionProgress += elapsed;
+        for (size_t skipped = 0; layer.actionProgress >= layer.active->actions[layer.currentActionIdx].period; skipped++) {
+            const auto& done = layer.active->actions[layer.currentActionIdx];
+            const uint32_t rest = layer.actionProgress - done.period;
+            layer.prevActionValue = done.value;
+
+            size_t next = layer.currentActionIdx + 1;
+            if (next >= layer.active->length) {
+                if (!layer.active->looping) {
+                    layer.working = false;
+                    return false;
                 }
-                driver.set(value);
-            } else {
-                driver.set(action.value);
+                next = 0;
             }
 
-            // If action end reached, prepare next step
-            if (actionProgress >= action.period) {
-                prevActionValue = action.value;
-                currentActionIdx++;
-                actionProgress = 0;
-
-                // If sequence end reached...
-                if (currentActionIdx >= sequence.length) {
-                    working = false;
-                    // If looping, start over
-                    if (sequence.looping) hasNewJob = true;
-                    else driver.set(backgroundValue);
-                }
+            startAction(layer, next);
+            layer.actionProgress = rest;
+
+            // Looping sequence of zero-length steps, stay on the last one
+            if (skipped > layer.active->length) {
+                layer.actionProgress = layer.active->actions[next].period;
+                break;
+            }
+        }
+
+        const auto& action = layer.active->actions[layer.currentActionIdx];
+
+        // Calculate led value. Division is replaced by reciprocal, computed
+        // once per action. Static step value is copied only once.
+        layer.updated = action.isAnimated || layer.stepStarted;
+        layer.stepStarted = false;
+
+        if (action.isAnimated) {
+            const uint32_t progress = blinker_curves_ns::progress(layer.actionProgress, action.period, layer.actionReciprocal);
+            for (int i = 0; i < Driver::ChannelsCount; i++) {
+                layer.value[i] = blinker_curves_ns::interpolate(layer.prevActionValue[i], action.value[i], progress, action.curve);
+            }
+        } else if (layer.updated) {
+            layer.value = action.value;
+        }
+
+        return true;
+    }
+
+    void startAction(Layer& layer, size_t idx) {
+        layer.currentActionIdx = idx;
+        layer.actionProgress = 0;
+        layer.stepStarted = true;
+        layer.actionReciprocal = blinker_curves_ns::progressReciprocal(layer.active->actions[idx].period);
+    }
+
+    void wake() {
+        if (wakeHandler) wakeHandler();
+    }
+
+    static void blend(typename Driver::DataType& output, const typename Driver::DataType& value, BlinkerBlend mode) {
+        for (int i = 0; i < Driver::ChannelsCount; i++) {
+            switch (mode) {
+                case BlinkerBlend::OVERRIDE: output[i] = value[i]; break;
+                case BlinkerBlend::MAX: output[i] = std::max(output[i], value[i]); break;
+                case BlinkerBlend::ADD: output[i] = uint8_t(std::min(255, output[i] + value[i])); break;
             }
         }
     }
 
-private:
-    struct Sequence {
-        std::array<Action, 20> actions;
-        size_t length;
-        bool looping;
-    };
+    bool updateSequence(size_t layer, const Action* actions, size_t length, bool looping, bool copy) {
+        if (!length || layer >= Layers) return false;
+
+        Slot* slot = acquireSlot();
+        if (!slot) return false;
+
+        if (copy) {
+            slot->storage.assign(actions, actions + length);
+            actions = slot->storage.data();
+        }
+        slot->actions = actions;
+        slot->length = length;
+        slot->looping = looping;
+
+        // Publish. If previous one was not taken by ticker yet, drop it.
+        Slot* replaced = layers[layer].pending.exchange(slot, std::memory_order_acq_rel);
+        release(replaced);
+        wake();
+        return true;
+    }
 
-    void updateSequence(const std::initializer_list<Action>& actionsList, bool looping) {
-        Sequence sequence;
-        sequence.looping = looping;
-        std::copy(actionsList.begin(), actionsList.end(), sequence.actions.begin());
-        sequence.length = actionsList.size();
+    Slot* acquireSlot() {
+        for (auto& slot : pool) {
+            bool expected = false;
+            if (slot.busy.compare_exchange_strong(expected, true, std::memory_order_acquire)) return &slot;
+        }
+        return nullptr;
+    }
 
-        sequenceQueue.write(sequence);
+    void release(Slot* slot) {
+        if (slot && slot != &stopSlot) slot->busy.store(false, std::memory_order_release);
     }
 
     Driver driver;
-    BlinkerSimpleQueue<Sequence> sequenceQueue;
-    BlinkerSimpleQueue<typename Driver::DataType> backgroundQueue;
+    // Writes may come from multiple threads
+    Slot pool[POOL_SIZE];
+    Slot stopSlot; // Marker of stop request, not a part of pool
+    SeqLock<typename Driver::DataType, true> backgroundQueue;
+    typename SeqLock<typename Driver::DataType, true>::Cursor backgroundCursor;
 
     // Ticker states
     uint32_t prevTickTs;
-    bool hasNewJob;
-    bool working;
-    Sequence sequence;
     typename Driver::DataType backgroundValue;
-    uint8_t currentActionIdx;
-    uint32_t actionProgress;
-    typename Driver::DataType prevActionValue;
+    typename Driver::DataType frame{}; // Last output, before gamma
+    Layer layers[Layers];
+    bool gamma = false;
+    void (*wakeHandler)() = nullptr;
 };
@@ -1,20 +1,52 @@
 #include "button.hpp"
 #include "logger.hpp"
+#include "scheduler.hpp"
+#include "async_preference/prefs.hpp"
 #include "app.hpp"
+#include "utils/triple_buffer.hpp"
 
 Button button;
 
-void button_thread(void* pvParameters) {
-    while (true) {
-        button.tick(millis());
-        vTaskDelay(pdMS_TO_TICKS(10));
-    }
+namespace {
+
+int button_job = -1;
+
+constexpr PreferenceKey BUTTON_TIMING_KEY{"settings", "btn_timing"};
+AsyncPreference<ButtonTiming> buttonTimingPref(prefsKV, BUTTON_TIMING_KEY);
+
+// Timing updates from prefs writer, applied by button job
+TripleBuffer<ButtonTiming> timingUpdate;
+
+void IRAM_ATTR onButtonEdge() { scheduler_wake_from_isr(button_job); }
+
+void applyTiming(const ButtonTiming& timing) {
+    if (!button.setTiming(timing)) DEBUG("Invalid button timing, defaults used");
+}
+
 }
 
 void button_init() {
     button.setEventHandler([](ButtonEventId event) {
-        app.receive(ButtonAction(event));
+        app.post(ButtonAction(event));
+    });
+
+    // Timing is tunable from settings. Subscriber is called from prefs
+    // writer, so new value is handed over to button job, not set directly.
+    prefsWriter.add(buttonTimingPref);
+    applyTiming(buttonTimingPref.get());
+    buttonTimingPref.subscribe([](const ButtonTiming& timing, void*) {
+        timingUpdate.write(timing);
+        scheduler_wake(button_job);
+    });
+
+    // Button is ticked only at debounce and gesture deadlines. Edge
+    // interrupt wakes it up.
+    static_assert(Button::NEVER == Scheduler::NEVER, "Deadline markers should match");
+    button_job = scheduler.add([](uint32_t now) {
+        ButtonTiming timing;
+        if (timingUpdate.read(timing)) applyTiming(timing);
+        return button.tick(now);
     });
 
-    xTaskCreate(button_thread, "button_thread", 1024 * 4, NULL, 1, NULL);
+    ButtonEdgeDriver::onEdgeCallback = onButtonEdge;
 }
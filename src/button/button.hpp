@@ -1,7 +1,11 @@
 #pragma once
 
 #include <Arduino.h>
+#include <atomic>
+#include <esp_timer.h>
+#include <hal/gpio_ll.h>
 #include "button_engine.hpp"
+#include "utils/ring_queue.hpp"
 
 class ButtonDriver : public IButtonDriver {
 public:
@@ -18,7 +22,57 @@ private:
     bool initialized;
 };
 
-using Button = ButtonEngine<ButtonDriver>;
+// Edges are captured by GPIO interrupt with timestamps, so engine does not
+// need to poll the pin while button is untouched.
+class ButtonEdgeDriver : public IButtonDriver {
+public:
+    ButtonEdgeDriver() : initialized(false) {};
+
+    bool get() override { return digitalRead(btnPin) == LOW; }
+
+    bool popEdge(ButtonEdge& edge) {
+        if (!initialized) {
+            initialized = true;
+            pinMode(btnPin, INPUT_PULLUP);
+            attachInterrupt(digitalPinToInterrupt(btnPin), onEdge, CHANGE);
+            // Report initial level
+            edge = { millis(), get() };
+            return true;
+        }
+
+        if (edges.pop(edge)) return true;
+
+        // Some edges were lost, resync with actual level
+        if (overflow.exchange(false)) {
+            edge = { millis(), get() };
+            return true;
+        }
+        return false;
+    }
+
+    // Called from ISR after each edge. Should be plain IRAM_ATTR function,
+    // calling only IRAM-safe code.
+    static inline void (*onEdgeCallback)() = nullptr;
+
+private:
+    static constexpr uint8_t btnPin = 9;
+    bool initialized;
+
+    static inline SpscRingQueue<ButtonEdge, 32> edges;
+    static inline std::atomic<bool> overflow{false};
+
+    // With CONFIG_ARDUINO_ISR_IRAM, GPIO interrupt can come while flash
+    // cache is disabled, and the whole call chain should be in IRAM. But
+    // `digitalRead()` is in IRAM only with that option, so timestamp & level
+    // are read directly (esp_timer & GPIO register). Queue push is inlined.
+    static void IRAM_ATTR onEdge() {
+        const uint32_t timestamp = static_cast<uint32_t>(esp_timer_get_time() / 1000);
+        if (!edges.push({ timestamp, gpio_ll_get_level(&GPIO, btnPin) == 0 })) overflow = true;
+        if (onEdgeCallback) onEdgeCallback();
+    }
+};
+
+using Button = ButtonEngine<ButtonEdgeDriver>;
 
 extern Button button;
 void button_init();
@@ -1,165 +1,135 @@
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
+#include <type_traits>
+#include <utility>
+#include "button_gesture.hpp"
 
 class IButtonDriver {
     virtual bool get() = 0;
 };
 
-enum class ButtonEventId {
-    //BUTTON_SEQUENCE_START,
-    //BUTTON_SEQUENCE_END,
-    BUTTON_LONG_PRESS_START,
-    BUTTON_LONG_PRESS_FAIL,
-    BUTTON_LONG_PRESS,
-    BUTTON_PRESSED_1X,
-    BUTTON_PRESSED_2X,
-    BUTTON_PRESSED_3X,
-    BUTTON_PRESSED_4X,
-    BUTTON_PRESSED_5X
+// Button level change, captured by interrupt
+struct ButtonEdge {
+    uint32_t timestamp;
+    bool pressed;
 };
 
+// Drivers with `bool popEdge(ButtonEdge&)` report edges instead of polling
+template <typename T, typename = void>
+struct IsEdgeButtonDriver : std::false_type {};
+
+template <typename T>
+struct IsEdgeButtonDriver<T, std::void_t<decltype(std::declval<T&>().popEdge(std::declval<ButtonEdge&>()))>> : std::true_type {};
+
 template <typename Driver>
 class ButtonEngine {
 public:
-    ButtonEngine() : driver(), state(START), unfilteredBtn(false), btnPressed(false),
-        unfilteredBtnTimestamp(0), btnToggleTimestamp(0), prevPeriod(0), currentPeriod(0) {}
-
-    void setEventHandler(void (*handler)(ButtonEventId)) { eventHandler = handler; }
+    // tick() result when nothing happens until the next edge
+    static constexpr uint32_t NEVER = UINT32_MAX;
+    // Polling drivers can't report edges, and should be polled all the time
+    static constexpr uint32_t POLL_PERIOD = 10;
 
-    static constexpr uint32_t JITTER_THRESHOLD = 50;
-    static constexpr uint32_t SHORT_PRESS_THRESHOLD = 500;
-    static constexpr uint32_t LONG_PRESS_THRESHOLD = 2000;
+    ButtonEngine() : driver(), eventHandler(nullptr), synced(false), unfilteredBtn(false), btnPressed(false),
+        unfilteredBtnTimestamp(0), lastTimestamp(0) {}
 
-    void tick(uint32_t ms_timestamp) {
-        // Sync initial timestamps
-        if (unfilteredBtnTimestamp == 0 || btnToggleTimestamp == 0) {
-            unfilteredBtnTimestamp = ms_timestamp;
-            btnToggleTimestamp = ms_timestamp;
-            return;
-        }
+    void setEventHandler(void (*handler)(ButtonEventId)) { eventHandler = handler; }
 
-        // Start measure jitter
-        if (unfilteredBtn != driver.get()) {
-            unfilteredBtn = driver.get();
+    // Should be called from the same thread as tick()
+    // Invalid timing falls back to defaults. Returns false in this case.
+    bool setTiming(const ButtonTiming& t) {
+        timing = t.isValid() ? t : ButtonTiming();
+        return t.isValid();
+    }
+    const ButtonTiming& getTiming() const { return timing; }
+
+    // Returns ms until the next debounce or gesture timeout. For edge
+    // drivers that's NEVER when idle, and the next edge should wake tick().
+    uint32_t tick(uint32_t ms_timestamp) {
+        // Sync initial timestamps. Edge driver should be polled anyway, to
+        // start capture.
+        if (!synced) {
+            synced = true;
             unfilteredBtnTimestamp = ms_timestamp;
+            lastTimestamp = ms_timestamp;
+            gesture.reset(false, ms_timestamp);
+            if constexpr (!IsEdgeButtonDriver<Driver>::value) return POLL_PERIOD;
         }
 
-        // Update filtered values
-        if ((ms_timestamp - unfilteredBtnTimestamp) > JITTER_THRESHOLD && (btnPressed != unfilteredBtn)) {
-            btnPressed = unfilteredBtn;
-            prevPeriod = ms_timestamp - btnToggleTimestamp;
-            btnToggleTimestamp = ms_timestamp;
-        }
-        currentPeriod = ms_timestamp - btnToggleTimestamp;
-
-        switch (state)
-        {
-        case START:
-            if (btnPressed) {
-                //handleEvent(ButtonEventId::BUTTON_SEQUENCE_START);
-                state = CHECK_FIRST_PRESS;
-                return;
-            }
-            return;
-
-        case CHECK_FIRST_PRESS:
-            if (btnPressed && currentPeriod >= SHORT_PRESS_THRESHOLD) {
-                state = WAIT_LONG_PRESS;
-                handleEvent(ButtonEventId::BUTTON_LONG_PRESS_START);
-                return;
-            }
-
-            if (!btnPressed) {
-                shortPressesCounter = 1;
-                state = WAIT_SHORT_RELEASE;
-                return;
-            }
-            return;
-
-        case WAIT_LONG_PRESS:
-            if (btnPressed && currentPeriod > LONG_PRESS_THRESHOLD) {
-                state = WAIT_LONG_RELEASE;
-                handleEvent(ButtonEventId::BUTTON_LONG_PRESS);
-                return;
+        if constexpr (IsEdgeButtonDriver<Driver>::value) {
+            // Replay captured edges at their own time, then catch up to now
+            ButtonEdge edge;
+            while (driver.popEdge(edge)) {
+                // Edge can be captured concurrently with tick start, keep
+                // time monotonic.
+                uint32_t ts = edge.timestamp;
+                if (int32_t(ts - lastTimestamp) < 0) ts = lastTimestamp;
+                if (int32_t(ts - ms_timestamp) > 0) ts = ms_timestamp;
+
+                update(ts);
+                setUnfiltered(edge.pressed, ts);
             }
+        } else {
+            setUnfiltered(driver.get(), ms_timestamp);
+        }
 
-            // Released too early => terminate
-            if (!btnPressed) {
-                state = START;
-                handleEvent(ButtonEventId::BUTTON_LONG_PRESS_FAIL);
-                //handleEvent(ButtonEventId::BUTTON_SEQUENCE_END);
-                return;
-            }
-            return;
+        update(ms_timestamp);
 
-        case WAIT_LONG_RELEASE:
-            if (!btnPressed) {
-                state = START;
-                //handleEvent(ButtonEventId::BUTTON_SEQUENCE_END);
-                return;
-            }
-            return;
-
-        case WAIT_SHORT_RELEASE:
-            // If button pressed fast again => proceed next click
-            if (btnPressed && currentPeriod < SHORT_PRESS_THRESHOLD) {
-                state = WAIT_SHORT_PRESS;
-                return;
-            }
+        return nextDeadline(ms_timestamp);
+    }
 
-            // Button stays released long enough => sequence finished
-            if (currentPeriod >= SHORT_PRESS_THRESHOLD) {
-                state = START;
-                if (shortPressesCounter <= 5) {
-                    handleEvent(static_cast<ButtonEventId>(static_cast<uint8_t>(ButtonEventId::BUTTON_PRESSED_1X) + shortPressesCounter - 1));
-                }
-                //handleEvent(ButtonEventId::BUTTON_SEQUENCE_END);
-                return;
-            }
-            return;
-
-        case WAIT_SHORT_PRESS:
-            // If button pressed too long => bad sequence of short dials
-            if (btnPressed && currentPeriod >= SHORT_PRESS_THRESHOLD) {
-                state = START;
-                //handleEvent(ButtonEventId::BUTTON_SEQUENCE_END);
-                return;
-            }
-        
-            // If button released fast enouth => go to pause measurement
-            if (!btnPressed) {
-                shortPressesCounter++;
-                state = WAIT_SHORT_RELEASE;
-                return;
-            }
-            return;
-        }
+    // True if nothing happens until the next edge. Then edge-driven button
+    // does not need ticks.
+    bool isIdle() const {
+        return synced && gesture.isIdle() && !btnPressed && !unfilteredBtn;
     }
 
 private:
-    enum State {
-        START,
-        CHECK_FIRST_PRESS,
-        WAIT_LONG_PRESS,
-        WAIT_LONG_RELEASE,
-        WAIT_SHORT_RELEASE,
-        WAIT_SHORT_PRESS
-    };
-
     Driver driver;
     void (*eventHandler)(ButtonEventId);
 
-    State state;
+    ButtonGesture gesture;
+    ButtonTiming timing;
+    bool synced;
     bool unfilteredBtn;
     bool btnPressed;
     uint32_t unfilteredBtnTimestamp;
-    uint32_t btnToggleTimestamp;
-    uint32_t prevPeriod;
-    uint32_t currentPeriod;
-    uint8_t shortPressesCounter;
+    uint32_t lastTimestamp;
 
     void handleEvent(ButtonEventId event) {
         if (eventHandler) eventHandler(event);
     }
+
+    // Start measure jitter
+    void setUnfiltered(bool pressed, uint32_t ms_timestamp) {
+        if (unfilteredBtn != pressed) {
+            unfilteredBtn = pressed;
+            unfilteredBtnTimestamp = ms_timestamp;
+        }
+    }
+
+    uint32_t nextDeadline(uint32_t ms_timestamp) const {
+        uint32_t next = gesture.timeLeft(ms_timestamp, timing);
+
+        // Debounce completes when jitter is exceeded
+        if (btnPressed != unfilteredBtn) {
+            const uint32_t passed = ms_timestamp - unfilteredBtnTimestamp;
+            next = std::min(next, passed > timing.jitter ? 0 : timing.jitter + 1 - passed);
+        }
+
+        if constexpr (!IsEdgeButtonDriver<Driver>::value) next = std::min(next, POLL_PERIOD);
+        return next;
+    }
+
+    void update(uint32_t ms_timestamp) {
+        lastTimestamp = ms_timestamp;
+
+        // Update filtered values
+        if ((ms_timestamp - unfilteredBtnTimestamp) > timing.jitter && (btnPressed != unfilteredBtn)) {
+            btnPressed = unfilteredBtn;
+        }
+
+        gesture.update(btnPressed, ms_timestamp, timing, [this](ButtonEventId event) { handleEvent(event); });
+    }
 };
@@ -0,0 +1,224 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+enum class ButtonEventId {
+    //BUTTON_SEQUENCE_START,
+    //BUTTON_SEQUENCE_END,
+    BUTTON_LONG_PRESS_START,
+    BUTTON_LONG_PRESS_FAIL,
+    BUTTON_LONG_PRESS,
+    BUTTON_PRESSED_1X,
+    BUTTON_PRESSED_2X,
+    BUTTON_PRESSED_3X,
+    BUTTON_PRESSED_4X,
+    BUTTON_PRESSED_5X,
+    // Several buttons pressed together (multi-button engines only)
+    BUTTON_CHORD,
+    // Repeated periodically while long press is held
+    BUTTON_HOLD_REPEAT,
+    // Click, then press and hold
+    BUTTON_PRESSED_2X_HOLD
+};
+
+// Gesture timings, ms. Trivially copyable, to be stored in preferences.
+struct ButtonTiming {
+    uint16_t jitter = 50;        // Debounce
+    uint16_t short_press = 500;  // Max click length, and max pause between clicks
+    uint16_t long_press = 2000;  // Long press length, from press start
+    uint16_t hold_repeat = 0;    // HOLD_REPEAT period after long press, 0 => off
+    uint8_t max_clicks = 5;      // Longer click series are ignored (up to 5)
+
+    // Settings come from flash and RPC. Zero or inverted thresholds disable
+    // timeouts or make gestures unreachable, so those are rejected.
+    bool isValid() const {
+        return jitter < short_press && short_press < long_press && max_clicks > 0 &&
+            (hold_repeat == 0 || hold_repeat > jitter);
+    }
+};
+
+namespace button_gesture_ns {
+
+enum State : uint8_t {
+    IDLE,
+    FIRST_PRESS,  // Can become click or long press
+    LONG_WAIT,    // Long press started, waiting for threshold
+    LONG_HOLD,    // Long press reached, waiting for release
+    CLICK_PAUSE,  // Released after click, waiting for the next one
+    NEXT_PRESS,   // Pressed again in clicks series
+    WAIT_RELEASE, // Gesture finished or cancelled, waiting for release
+    STATES_COUNT
+};
+
+enum Input : uint8_t { PRESS, RELEASE, TIMEOUT, INPUTS_COUNT };
+
+enum Action : uint8_t {
+    NONE,
+    CLICK,        // Count click
+    EMIT_CLICKS,  // Report clicks series
+    EMIT_CLICK_HOLD,
+    EMIT_LONG_START,
+    EMIT_LONG_FAIL,
+    EMIT_LONG,
+    EMIT_REPEAT
+};
+
+// Which timing limits time in state
+enum Timer : uint8_t { NO_TIMER, SHORT, LONG_REST, REPEAT };
+
+struct Rule {
+    State from;
+    Input input;
+    State to;
+    Action action;
+};
+
+// Gestures description. Edit this list to add gestures, the tick code
+// does not change.
+constexpr Rule RULES[] = {
+    { IDLE,         PRESS,   FIRST_PRESS,  NONE },
+
+    { FIRST_PRESS,  RELEASE, CLICK_PAUSE,  CLICK },
+    { FIRST_PRESS,  TIMEOUT, LONG_WAIT,    EMIT_LONG_START },
+
+    { LONG_WAIT,    RELEASE, IDLE,         EMIT_LONG_FAIL },
+    { LONG_WAIT,    TIMEOUT, LONG_HOLD,    EMIT_LONG },
+
+    { LONG_HOLD,    RELEASE, IDLE,         NONE },
+    { LONG_HOLD,    TIMEOUT, LONG_HOLD,    EMIT_REPEAT },
+
+    { CLICK_PAUSE,  PRESS,   NEXT_PRESS,   NONE },
+    { CLICK_PAUSE,  TIMEOUT, IDLE,         EMIT_CLICKS },
+
+    { NEXT_PRESS,   RELEASE, CLICK_PAUSE,  CLICK },
+    { NEXT_PRESS,   TIMEOUT, WAIT_RELEASE, EMIT_CLICK_HOLD },
+
+    { WAIT_RELEASE, RELEASE, IDLE,         NONE },
+};
+
+constexpr Timer STATE_TIMERS[STATES_COUNT] = {
+    NO_TIMER,  // IDLE
+    SHORT,     // FIRST_PRESS
+    LONG_REST, // LONG_WAIT
+    REPEAT,    // LONG_HOLD
+    SHORT,     // CLICK_PAUSE
+    SHORT,     // NEXT_PRESS
+    NO_TIMER   // WAIT_RELEASE
+};
+
+struct Transition {
+    State to;
+    Action action;
+    bool valid; // Missing rules keep state
+};
+
+using Table = std::array<std::array<Transition, INPUTS_COUNT>, STATES_COUNT>;
+
+template <size_t R>
+constexpr Table compile(const Rule (&rules)[R]) {
+    Table table{};
+    for (size_t i = 0; i < R; i++) {
+        table[rules[i].from][rules[i].input] = { rules[i].to, rules[i].action, true };
+    }
+    return table;
+}
+
+constexpr Table TABLE = compile(RULES);
+
+}
+
+// Gesture recognizer of single button: clicks series, long press and
+// alike. Input is debounced button level. Transitions come from table,
+// compiled from `button_gesture_ns::RULES`.
+class ButtonGesture {
+public:
+    ButtonGesture() : state(button_gesture_ns::IDLE), pressed(false), stateTimestamp(0), clicks(0) {}
+
+    // Drop gesture in progress without events
+    void reset(bool btnPressed, uint32_t ms_timestamp) {
+        state = btnPressed ? button_gesture_ns::WAIT_RELEASE : button_gesture_ns::IDLE;
+        pressed = btnPressed;
+        stateTimestamp = ms_timestamp;
+    }
+
+    bool isIdle() const { return state == button_gesture_ns::IDLE && !pressed; }
+
+    // LONG_PRESS_START was reported, but neither LONG_PRESS nor FAIL yet
+    bool isLongPressStarted() const { return state == button_gesture_ns::LONG_WAIT; }
+
+    // Time until current state expires, UINT32_MAX if state has no timeout
+    uint32_t timeLeft(uint32_t ms_timestamp, const ButtonTiming& timing) const {
+        const uint32_t timeout = stateTimeout(timing);
+        if (!timeout) return UINT32_MAX;
+
+        const uint32_t passed = ms_timestamp - stateTimestamp;
+        return passed >= timeout ? 0 : timeout - passed;
+    }
+
+    // Calls `emit(ButtonEventId)` for recognized events
+    template <typename Emit>
+    void update(bool btnPressed, uint32_t ms_timestamp, const ButtonTiming& timing, Emit&& emit) {
+        using namespace button_gesture_ns;
+
+        if (pressed != btnPressed) {
+            pressed = btnPressed;
+            apply(pressed ? PRESS : RELEASE, ms_timestamp, timing, emit);
+        }
+
+        const uint32_t timeout = stateTimeout(timing);
+        if (timeout && ms_timestamp - stateTimestamp >= timeout) apply(TIMEOUT, ms_timestamp, timing, emit);
+    }
+
+private:
+    button_gesture_ns::State state;
+    bool pressed;
+    uint32_t stateTimestamp;
+    uint8_t clicks;
+
+    // 0 => no timeout in current state
+    uint32_t stateTimeout(const ButtonTiming& timing) const {
+        using namespace button_gesture_ns;
+
+        switch (STATE_TIMERS[state]) {
+            case SHORT: return timing.short_press;
+            // Long press is counted from press start, that's the entry of
+            // previous state.
+            case LONG_REST: return timing.long_press > timing.short_press ? timing.long_press - timing.short_press : 1;
+            case REPEAT: return timing.hold_repeat;
+            default: return 0;
+        }
+    }
+
+    template <typename Emit>
+    void apply(button_gesture_ns::Input input, uint32_t ms_timestamp, const ButtonTiming& timing, Emit& emit) {
+        using namespace button_gesture_ns;
+
+        const Transition& t = TABLE[state][input];
+        if (!t.valid) return;
+
+        if (state == IDLE) clicks = 0;
+        state = t.to;
+        stateTimestamp = ms_timestamp;
+
+        switch (t.action) {
+            case CLICK:
+                if (clicks < UINT8_MAX) clicks++;
+                break;
+            case EMIT_CLICKS:
+                if (clicks <= timing.max_clicks && clicks <= 5) {
+                    emit(static_cast<ButtonEventId>(static_cast<uint8_t>(ButtonEventId::BUTTON_PRESSED_1X) + clicks - 1));
+                }
+                break;
+            case EMIT_CLICK_HOLD:
+                if (clicks == 1) emit(ButtonEventId::BUTTON_PRESSED_2X_HOLD);
+                break;
+            case EMIT_LONG_START: emit(ButtonEventId::BUTTON_LONG_PRESS_START); break;
+            case EMIT_LONG_FAIL: emit(ButtonEventId::BUTTON_LONG_PRESS_FAIL); break;
+            case EMIT_LONG: emit(ButtonEventId::BUTTON_LONG_PRESS); break;
+            case EMIT_REPEAT: emit(ButtonEventId::BUTTON_HOLD_REPEAT); break;
+            default: break;
+        }
+    }
+};
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "button_gesture.hpp"
+
+// Engine for N buttons (keypad), with driver returning all levels as bitmask
+// in one read: `uint32_t getMask()`, bit N set => button N pressed.
+//
+// Debounce works on whole masks. Gesture recognizers run only for buttons,
+// touched recently, so idle buttons cost nothing. When several buttons are
+// pressed together, their single-button gestures are cancelled, and
+// BUTTON_CHORD with mask of all involved buttons is reported on release.
+// Cancelled long press is reported as BUTTON_LONG_PRESS_FAIL, to let
+// subscribers stop feedback, started on BUTTON_LONG_PRESS_START.
+template <typename Driver, size_t N>
+class ButtonMatrixEngine {
+public:
+    static_assert(N > 0 && N <= 32, "Up to 32 buttons supported");
+
+    static constexpr uint32_t ALL_BUTTONS = N == 32 ? 0xFFFFFFFF : (1u << N) - 1;
+
+    ButtonMatrixEngine() : driver(), eventHandler(nullptr), timing(), synced(false), unfiltered(0),
+        filtered(0), bouncing(0), active(0), chord(0), changeTimestamps{} {}
+
+    // Handler receives event and mask of buttons (single bit for gestures
+    // of one button)
+    void setEventHandler(void (*handler)(ButtonEventId, uint32_t)) { eventHandler = handler; }
+
+    // Common for all buttons. Should be called from the same thread as tick().
+    // Invalid timing falls back to defaults. Returns false in this case.
+    bool setTiming(const ButtonTiming& t) {
+        timing = t.isValid() ? t : ButtonTiming();
+        return t.isValid();
+    }
+    const ButtonTiming& getTiming() const { return timing; }
+
+    void tick(uint32_t ms_timestamp) {
+        if (!synced) {
+            synced = true;
+            for (auto& gesture : gestures) gesture.reset(false, ms_timestamp);
+        }
+
+        // Start measure jitter of changed buttons
+        const uint32_t raw = driver.getMask() & ALL_BUTTONS;
+        const uint32_t changed = raw ^ unfiltered;
+        unfiltered = raw;
+        bouncing |= changed;
+        forEachBit(changed, [&](size_t i) { changeTimestamps[i] = ms_timestamp; });
+
+        // Accept levels, stable long enough
+        uint32_t settled = 0;
+        forEachBit(bouncing, [&](size_t i) {
+            if (ms_timestamp - changeTimestamps[i] > timing.jitter) settled |= 1u << i;
+        });
+        bouncing &= ~settled;
+        filtered = (filtered & ~settled) | (unfiltered & settled);
+        active |= settled;
+
+        updateChord(ms_timestamp);
+
+        forEachBit(active & ~chord, [&](size_t i) {
+            gestures[i].update(filtered & (1u << i), ms_timestamp, timing, [&](ButtonEventId event) {
+                handleEvent(event, 1u << i);
+            });
+            if (gestures[i].isIdle()) active &= ~(1u << i);
+        });
+    }
+
+    uint32_t pressed() const { return filtered; }
+
+    // True if no buttons touched and no gestures in progress
+    bool isIdle() const { return synced && !active && !bouncing && !chord && !unfiltered; }
+
+private:
+    Driver driver;
+    void (*eventHandler)(ButtonEventId, uint32_t);
+
+    ButtonTiming timing;
+    bool synced;
+    uint32_t unfiltered;
+    uint32_t filtered;
+    uint32_t bouncing; // Buttons with unfiltered level change, not settled yet
+    uint32_t active;   // Buttons with gestures in progress
+    uint32_t chord;    // Buttons of chord in progress
+    uint32_t changeTimestamps[N];
+    ButtonGesture gestures[N];
+
+    void handleEvent(ButtonEventId event, uint32_t buttons) {
+        if (eventHandler) eventHandler(event, buttons);
+    }
+
+    void updateChord(uint32_t ms_timestamp) {
+        // 2+ buttons pressed => start (or extend) chord
+        if (filtered & (filtered - 1)) {
+            const uint32_t added = filtered & ~chord;
+            chord |= filtered;
+            forEachBit(added, [&](size_t i) {
+                if (gestures[i].isLongPressStarted()) handleEvent(ButtonEventId::BUTTON_LONG_PRESS_FAIL, 1u << i);
+                gestures[i].reset(true, ms_timestamp);
+            });
+            active &= ~chord;
+            return;
+        }
+
+        // Chord finishes when all its buttons are released
+        if (chord && !(filtered & chord)) {
+            handleEvent(ButtonEventId::BUTTON_CHORD, chord);
+            forEachBit(chord, [&](size_t i) { gestures[i].reset(false, ms_timestamp); });
+            chord = 0;
+        }
+    }
+
+    template <typename Fn>
+    static void forEachBit(uint32_t mask, Fn&& fn) {
+        while (mask) {
+            fn(size_t(__builtin_ctz(mask)));
+            mask &= mask - 1;
+        }
+    }
+};
@@ -1,23 +1,30 @@
 #include <Arduino.h>
 #include "logger.hpp"
+#include "scheduler.hpp"
 
 Logger logger;
 
 char outputBuffer[1024];
 
-static void LogOutputTask(void* pvParameters) {
+namespace {
+
+int logger_job = -1;
+
+}
+
+void logger_init() {
     Serial.begin(115200);
 
-    while (!Serial) vTaskDelay(pdMS_TO_TICKS(10));
+    // Drain is run only after new messages. Until serial is ready, messages
+    // are kept in buffer and go out after the next push.
+    logger_job = scheduler.add([](uint32_t) {
+        if (!Serial) return Scheduler::NEVER;
 
-    while (true) {
         while (logger.pull(outputBuffer, sizeof(outputBuffer))) {
             Serial.println(outputBuffer);
         }
-        vTaskDelay(pdMS_TO_TICKS(10));
-    }
-}
+        return Scheduler::NEVER;
+    });
 
-void logger_init() {
-    xTaskCreate(LogOutputTask, "LogOutputTask", 1024 * 4, NULL, 1, NULL);
-}
\ No newline at end of file
+    logger.setPushHandler([]() { scheduler_wake(logger_job); });
+}
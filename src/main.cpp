@@ -4,6 +4,7 @@
 #include "rpc/rpc.hpp"
 #include "async_preference/prefs.hpp"
 #include "app.hpp"
+#include "scheduler.hpp"
 
 void setup() {
     logger_init();
@@ -11,12 +12,10 @@ void setup() {
     blinker_init();
     button_init();
 
-    // Demo methods
-    rpc.addMethod("echo", [](const std::string msg)-> std::string { return msg; });
-    rpc.addMethod("devnull", [](const std::string msg)-> bool { return true; });
-
     rpc_init();
     app_init();
+
+    scheduler_start();
 }
 
 void loop() {}
\ No newline at end of file
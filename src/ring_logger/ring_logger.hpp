@@ -46,6 +46,9 @@ class RingLogger {
 public:
     RingLogger() {}
 
+    // Called after each record push, to wake output task. Not ISR safe.
+    void setPushHandler(void (*handler)()) { pushHandler = handler; }
+
     template<RingLoggerLevel level, typename... Args>
     void push(const char* message, const Args&... msgArgs) {
         lpush<level, nullptr>(message, msgArgs...);
@@ -68,11 +71,13 @@ public:
         if (packedSize > MaxRecordSize) {
             auto packedData = packer.pack(timestamp, level_as_byte, safe_label, "[TOO BIG]");
             ringBuffer.writeRecord(packedData.data, packedData.size);
+            if (pushHandler) pushHandler();
             return;
         }
 
         auto packedData = packer.pack(timestamp, level_as_byte, safe_label, message, msgArgs...);
         ringBuffer.writeRecord(packedData.data, packedData.size);
+        if (pushHandler) pushHandler();
     }
 
     template<RingLoggerLevel level, const char* label, typename... Args>
@@ -144,6 +149,7 @@ public:
 private:
     ring_logger::Packer<MaxRecordSize, MaxArgs + 4> packer;
     ring_logger::RingBuffer<BufferSize> ringBuffer;
+    void (*pushHandler)() = nullptr;
 
     size_t writeLogHeader(char* outputBuffer, size_t bufferSize, uint32_t /*timestamp*/, RingLoggerLevel level, const char* label) {
         using namespace ring_logger;
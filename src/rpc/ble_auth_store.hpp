@@ -8,8 +8,13 @@ using BleAuthSecret = std::array<uint8_t, 32>;
 template<size_t MaxRecords = 4>
 class BleAuthStore : public AsyncPreferenceTickable {
 public:
+    static constexpr PreferenceKey CLIENTS_KEY{"ble_auth", "clients"};
+    static constexpr PreferenceKey TIMESTAMPS_KEY{"ble_auth", "timestamps"};
+
+    static_assert(CLIENTS_KEY.fitsPages(MaxRecords), "Page keys of clients don't fit NVS name limit");
+
     BleAuthStore(IAsyncPreferenceKV& kv) :
-        clientsPref(kv, "ble_auth", "clients"), timestampsPref(kv, "ble_auth", "timestamps") {}
+        clientsPref(kv, CLIENTS_KEY), timestampsPref(kv, TIMESTAMPS_KEY) {}
 
     struct Client {
         BleAuthId id{};
@@ -77,8 +82,38 @@ public:
         timestampsPref.tick();
     }
 
+    void save() override {
+        clientsPref.save();
+        timestampsPref.save();
+    }
+
+    void preload() override {
+        clientsPref.preload();
+        timestampsPref.preload();
+    }
+
+    const char* ns() const override { return CLIENTS_KEY.ns; }
+
+    bool hasPending() const override { return clientsPref.hasPending() || timestampsPref.hasPending(); }
+
+    void setWakeHandler(void (*handler)()) override {
+        clientsPref.setWakeHandler(handler);
+        timestampsPref.setWakeHandler(handler);
+    }
+
+    void setStatsClock(uint32_t (*get_time_us)()) override {
+        clientsPref.setStatsClock(get_time_us);
+        timestampsPref.setStatsClock(get_time_us);
+    }
+
+    void visitStats(const StatsVisitor& visitor) const override {
+        clientsPref.visitStats(visitor);
+        timestampsPref.visitStats(visitor);
+    }
+
 private:
-    AsyncPreference<std::array<Client, MaxRecords>> clientsPref;
+    // Page per record, to rewrite only modified one
+    AsyncPreference<std::array<Client, MaxRecords>, async_preference_ns::PagedSerializer<std::array<Client, MaxRecords>, sizeof(Client)>> clientsPref;
     AsyncPreference<std::array<uint64_t, MaxRecords>> timestampsPref;
 
     int8_t idxById(const BleAuthId& client_id) {
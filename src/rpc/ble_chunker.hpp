@@ -1,5 +1,6 @@
 #pragma once
 
+#include <deque>
 #include <vector>
 #include <functional>
 #include <cstdint>
@@ -43,6 +44,61 @@ public:
     void fillTo(std::vector<uint8_t>& chunk) const { fillTo(chunk.data()); }
 };
 
+// Outgoing chunks queue. Client reads chunks one by one from the front.
+using BleChunks = std::deque<std::vector<uint8_t>>;
+
+// Streams message into chunks, header of each is filled when chunk starts,
+// and final flag is set by `finish()`. Implements ArduinoJson Writer
+// interface, to serialize responses directly into outgoing frames, without
+// intermediate buffer.
+//
+// Memory is NOT constant: client reads response after it is built, so all
+// chunks are kept until read, ~ response size + 4 bytes per chunk.
+class BleChunkWriter {
+public:
+    BleChunkWriter(BleChunks& chunks, uint8_t messageId, size_t chunkSize)
+        : chunks(chunks), messageId(messageId), chunkSize(chunkSize), sequenceNumber(0), started(false) {}
+
+    size_t write(uint8_t c) { return write(&c, 1); }
+
+    size_t write(const uint8_t* data, size_t length) {
+        size_t left = length;
+        while (left) {
+            if (!started || chunks.back().size() >= chunkSize) startChunk();
+
+            auto& chunk = chunks.back();
+            const size_t n = std::min(left, chunkSize - chunk.size());
+            chunk.insert(chunk.end(), data, data + n);
+            data += n;
+            left -= n;
+        }
+        return length;
+    }
+
+    // Mark the last chunk as final. Empty message is sent as single header.
+    void finish() {
+        if (!started) startChunk();
+        BleChunkHead head(messageId, sequenceNumber - 1, BleChunkHead::FINAL_CHUNK_FLAG);
+        head.fillTo(chunks.back());
+    }
+
+private:
+    BleChunks& chunks;
+    uint8_t messageId;
+    size_t chunkSize;
+    uint16_t sequenceNumber;
+    bool started;
+
+    void startChunk() {
+        started = true;
+        chunks.emplace_back();
+        auto& chunk = chunks.back();
+        chunk.reserve(chunkSize);
+        chunk.resize(BleChunkHead::SIZE);
+        BleChunkHead(messageId, sequenceNumber++, 0).fillTo(chunk);
+    }
+};
+
 class BleChunker {
 public:
     BleChunker(size_t maxMessageSize = 65536)
@@ -100,9 +156,18 @@ public:
             // Set skipTail to true to prevent processing further chunks for this message
             skipTail = true;
 
-            // Process the complete message
-            if (onMessage) {
-                response = splitMessageToChunks(onMessage(assembledMessage));
+            // Process the complete message. Response goes directly to chunks.
+            if (onMessageStream || onMessage) {
+                response.clear();
+                BleChunkWriter writer(response, currentMessageId, MAX_CHUNK_SIZE);
+
+                if (onMessageStream) {
+                    onMessageStream(assembledMessage, writer);
+                } else {
+                    const std::vector<uint8_t> message = onMessage(assembledMessage);
+                    writer.write(message.data(), message.size());
+                }
+                writer.finish();
             }
         }
     }
@@ -117,13 +182,16 @@ public:
             return noData;
         }
 
+        // Read chunks are released right away
         std::vector<uint8_t> chunk = std::move(response.front());
-        response.erase(response.begin());
+        response.pop_front();
         return chunk;
     }
 
     std::function<std::vector<uint8_t>(const std::vector<uint8_t>& message)> onMessage;
-    std::vector<std::vector<uint8_t>> response;  // Store response chunks here
+    // Preferred over `onMessage`, writes response without intermediate copy
+    std::function<void(const std::vector<uint8_t>& message, BleChunkWriter& writer)> onMessageStream;
+    BleChunks response;  // Store response chunks here
 
 private:
     // Max DLE data size is 251 bytes. Every R/W to characteristic should be
@@ -149,41 +217,6 @@ private:
         skipTail = false;
     }
 
-    std::vector<std::vector<uint8_t>> splitMessageToChunks(const std::vector<uint8_t>& message) {
-        std::vector<std::vector<uint8_t>> chunks;
-        size_t totalSize = message.size();
-        size_t chunkSize = MAX_CHUNK_SIZE - BleChunkHead::SIZE;
-
-        if (totalSize == 0) {
-            // Handle case when message is empty, send only the header with FINAL_CHUNK_FLAG
-            std::vector<uint8_t> emptyChunk(BleChunkHead::SIZE);
-            BleChunkHead head(currentMessageId, 0, BleChunkHead::FINAL_CHUNK_FLAG);
-            head.fillTo(emptyChunk);
-            chunks.push_back(emptyChunk);
-            return chunks;
-        }
-
-        for (size_t i = 0; i < totalSize; i += chunkSize) {
-            size_t end = (i + chunkSize > totalSize) ? totalSize : i + chunkSize;
-
-            // Reserve space for the header and data
-            std::vector<uint8_t> chunk;
-            chunk.reserve(BleChunkHead::SIZE + (end - i));
-
-            // Insert the header
-            BleChunkHead head(currentMessageId, i / chunkSize, (end == totalSize) ? BleChunkHead::FINAL_CHUNK_FLAG : 0);
-            chunk.resize(BleChunkHead::SIZE);
-            head.fillTo(chunk);
-
-            // Insert the data
-            chunk.insert(chunk.end(), message.begin() + i, message.begin() + end);
-
-            chunks.push_back(chunk);
-        }
-
-        return chunks;
-    }
-
     void sendErrorResponse(uint8_t errorFlag) {
         std::vector<uint8_t> errorChunk(BleChunkHead::SIZE);
         BleChunkHead errorHead(currentMessageId, 0, errorFlag | BleChunkHead::FINAL_CHUNK_FLAG);
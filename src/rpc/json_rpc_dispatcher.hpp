@@ -24,13 +24,34 @@ int main() {
     input = R"({"method": "unknown", "args": []})";
     std::cout << dispatcher.dispatch(input) << std::endl;
 
+    // Batch, responses come in array, in the same order
+    input = R"([{"method": "add", "args": [1, 2]}, {"method": "add", "args": [3, 4]}])";
+    std::cout << dispatcher.dispatch(input) << std::endl;
+
     return 0;
 }
 
+When all methods are known at compile time, use static table instead. It
+has no heap allocations, and lookup is binary search over sorted names.
+Only free functions are allowed.
+
+int add(int a, int b) { return a + b; }
+
+constexpr auto METHODS = jrcpd::make_methods(
+    jrcpd::method<add>("add"),
+    jrcpd::method<concat>("concat")
+);
+
+JsonRpcDispatcher dispatcher(METHODS);
+
 */
 
 #pragma once
 
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include <string>
 #include <unordered_map>
 #include <functional>
@@ -189,22 +210,62 @@ const JsonDocument create_response(bool status, const T& result) {
     return doc;
 }
 
-inline void serialize_to(const JsonDocument& doc, std::string& output) {
-    serializeJson(doc, output);
+// JSON-RPC "Invalid Request" code, for errors of message as a whole
+constexpr int INVALID_REQUEST = -32600;
+
+// Wire format. Response is sent in the format of request.
+enum class Format { JSON, MSGPACK };
+
+// JSON request is an object, so it starts with `{` (or whitespace). Any
+// byte of MessagePack map or array header can't start JSON text.
+inline Format detect_format(const uint8_t* data, std::size_t size) {
+    if (!size) return Format::JSON;
+    const uint8_t first = data[0];
+    if ((first >= 0x80 && first <= 0x9f) || (first >= 0xdc && first <= 0xdf)) return Format::MSGPACK;
+    return Format::JSON;
 }
 
-inline void serialize_to(const JsonDocument& doc, std::vector<uint8_t>& output) {
+inline Format detect_format(const std::string& input) {
+    return detect_format(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+}
+
+inline Format detect_format(const std::vector<uint8_t>& input) {
+    return detect_format(input.data(), input.size());
+}
+
+inline void serialize_to(const JsonDocument& doc, std::string& output, Format format = Format::JSON) {
+    if (format == Format::MSGPACK) serializeMsgPack(doc, output);
+    else serializeJson(doc, output);
+}
+
+inline void serialize_to(const JsonDocument& doc, std::vector<uint8_t>& output, Format format = Format::JSON) {
+    if (format == Format::MSGPACK) {
+        size_t size = measureMsgPack(doc);
+        output.resize(size);
+        serializeMsgPack(doc, output.data(), size);
+        return;
+    }
+
     size_t size = measureJson(doc);
     output.resize(size);
     serializeJson(doc, output.data(), size);
     //serializeJson(doc, output);
 }
 
-inline DeserializationError deserialize_from(const std::string& input, JsonDocument& doc) {
+// Streaming writers with ArduinoJson Writer interface (BleChunkWriter, ...)
+template<typename Writer>
+void serialize_to(const JsonDocument& doc, Writer& output, Format format = Format::JSON) {
+    if (format == Format::MSGPACK) serializeMsgPack(doc, output);
+    else serializeJson(doc, output);
+}
+
+inline DeserializationError deserialize_from(const std::string& input, JsonDocument& doc, Format format = Format::JSON) {
+    if (format == Format::MSGPACK) return deserializeMsgPack(doc, input);
     return deserializeJson(doc, input);
 }
 
-inline DeserializationError deserialize_from(const std::vector<uint8_t>& input, JsonDocument& doc) {
+inline DeserializationError deserialize_from(const std::vector<uint8_t>& input, JsonDocument& doc, Format format = Format::JSON) {
+    if (format == Format::MSGPACK) return deserializeMsgPack(doc, input.data(), input.size());
     return deserializeJson(doc, input.data(), input.size());
 }
 
@@ -222,41 +283,98 @@ struct TypeChecker<ArgsTuple, N, N> {
     static bool check(const JsonArray&) { return true; }
 };
 
+// Call function with arguments from JSON, and wrap result (or error) into
+// response
+template<typename Func>
+JsonDocument invoke(const Func& func, const JsonArray& args) {
+    using traits = function_traits<Func>;
+    using Ret = typename traits::return_type;
+    using ArgsTuple = typename traits::argument_types;
+
+    static_assert(!std::is_same<Ret, void>::value, "void functions not supported");
+
+    static_assert(is_supported_type<Ret>::value, "Return type is not allowed");
+    static_assert(check_all_types_supported<ArgsTuple>(), "Argument type is not allowed");
+
+    try {
+        if (args.size() != std::tuple_size<ArgsTuple>::value) {
+            throw std::runtime_error("Number of arguments mismatch");
+        }
+
+        // Check if each argument in JsonArray can hold the appropriate type from ArgsTuple
+        if (!TypeChecker<ArgsTuple>::check(args)) {
+            throw std::runtime_error("Argument type mismatch");
+        }
+
+        auto tpl_args = jrcpd::from_json<ArgsTuple>(args);
+        Ret result = jrcpd::apply(func, tpl_args);
+        return create_response(true, result);
+    } catch (const std::exception& e) {
+        return create_response(false, e.what());
+    }
+}
+
+//
+// Static methods table, for methods set known at compile time
+//
+
+using MethodHandler = JsonDocument (*)(const JsonArray& args);
+
+struct Method {
+    const char* name;
+    MethodHandler handler;
+};
+
+template<auto Func>
+JsonDocument invoke_static(const JsonArray& args) { return invoke(Func, args); }
+
+// Table entry for free function. Argument and return types are checked at
+// compile time, as in `addMethod()`.
+template<auto Func>
+constexpr Method method(const char* name) { return { name, &invoke_static<Func> }; }
+
+constexpr int compare_names(const char* a, const char* b) {
+    while (*a && *a == *b) { a++; b++; }
+    return int(static_cast<unsigned char>(*a)) - int(static_cast<unsigned char>(*b));
+}
+
+// Sorted by name, for binary search. Duplicated names fail compilation,
+// when result is used as constexpr.
+template<typename... Methods>
+constexpr std::array<Method, sizeof...(Methods)> make_methods(Methods... methods) {
+    std::array<Method, sizeof...(Methods)> table{ methods... };
+
+    for (std::size_t i = 1; i < table.size(); i++) {
+        for (std::size_t j = i; j > 0; j--) {
+            const int order = compare_names(table[j - 1].name, table[j].name);
+            if (order == 0) throw std::logic_error("Duplicated RPC method name");
+            if (order < 0) break;
+
+            const Method tmp = table[j - 1];
+            table[j - 1] = table[j];
+            table[j] = tmp;
+        }
+    }
+    return table;
+}
+
 } // namespace jrcpd
 
 class JsonRpcDispatcher {
 public:
     JsonRpcDispatcher() = default;
 
+    // Static methods, from `jrcpd::make_methods()`. Table is used in place
+    // and should outlive dispatcher. `addMethod()` can extend it.
+    template<std::size_t N>
+    explicit JsonRpcDispatcher(const std::array<jrcpd::Method, N>& table)
+        : static_methods(table.data()), static_methods_count(N) {}
+
     // For functions with arguments
     template<typename Func>
     void addMethod(const std::string& name, Func func) {
-        using traits = jrcpd::function_traits<decltype(func)>;
-        using Ret = typename traits::return_type;
-        using ArgsTuple = typename traits::argument_types;
-
-        static_assert(!std::is_same<Ret, void>::value, "void functions not supported");
-
-        static_assert(jrcpd::is_supported_type<Ret>::value, "Return type is not allowed");
-        static_assert(jrcpd::check_all_types_supported<ArgsTuple>(), "Argument type is not allowed");
-
         functions[name] = [func](const JsonArray& args) -> JsonDocument {
-            try {
-                if (args.size() != std::tuple_size<ArgsTuple>::value) {
-                    throw std::runtime_error("Number of arguments mismatch");
-                }
-
-                // Check if each argument in JsonArray can hold the appropriate type from ArgsTuple
-                if (!jrcpd::TypeChecker<ArgsTuple>::check(args)) {
-                    throw std::runtime_error("Argument type mismatch");
-                }
-
-                auto tpl_args = jrcpd::from_json<ArgsTuple>(args);
-                Ret result = jrcpd::apply(func, tpl_args);
-                return jrcpd::create_response(true, result);
-            } catch (const std::exception& e) {
-                return jrcpd::create_response(false, e.what());
-            }
+            return jrcpd::invoke(func, args);
         };
     }
 
@@ -266,30 +384,79 @@ public:
         return output;
     }
 
+    // All batch responses are kept in memory until sent, so calls count is
+    // limited, to not exhaust heap by single message.
+    static constexpr std::size_t MAX_BATCH_DEFAULT = 16;
+
+    void setMaxBatch(std::size_t limit) { max_batch = limit; }
+
+    // Request is a single call object, or an array of calls (batch). Batch
+    // is answered with array of responses in the same order, so client can
+    // pack several calls into one message. Too long batch is rejected
+    // completely, with error object instead of array.
     template<typename T_IN, typename T_OUT>
     void dispatch(const T_IN& input, T_OUT& output) {
         using namespace jrcpd;
 
+        // JSON or MessagePack, selected by client per message
+        const Format format = detect_format(input);
+
         JsonDocument doc;
-        auto error = deserialize_from(input, doc);
+        auto error = deserialize_from(input, doc, format);
         if (error) {
-            serialize_to(create_response(false, error.c_str()), output);
+            serialize_to(create_response(false, error.c_str()), output, format);
             return;
         }
 
-        std::string method = doc["method"].as<std::string>();
-        JsonArray args = doc["args"].as<JsonArray>();
+        if (doc.is<JsonArray>()) {
+            if (doc.size() > max_batch) {
+                JsonDocument response = create_response(false, "Too many calls in batch");
+                response["code"] = INVALID_REQUEST;
+                serialize_to(response, output, format);
+                return;
+            }
 
-        auto it = functions.find(method);
-        if (it != functions.end()) {
-            serialize_to(it->second(args), output);
-            return;
-        } else {
-            serialize_to(create_response(false, "Method not found"), output);
+            JsonDocument response;
+            JsonArray results = response.to<JsonArray>();
+            for (JsonVariant request : doc.as<JsonArray>()) results.add(call(request));
+
+            serialize_to(response, output, format);
             return;
         }
+
+        serialize_to(call(doc.as<JsonVariant>()), output, format);
     }
 
 private:
+    const jrcpd::Method* static_methods = nullptr;
+    std::size_t static_methods_count = 0;
+    std::size_t max_batch = MAX_BATCH_DEFAULT;
     std::unordered_map<std::string, std::function<JsonDocument(const JsonArray&)>> functions;
+
+    jrcpd::MethodHandler find_static(const char* name) const {
+        const jrcpd::Method* end = static_methods + static_methods_count;
+        const jrcpd::Method* it = std::lower_bound(static_methods, end, name,
+            [](const jrcpd::Method& m, const char* n) { return std::strcmp(m.name, n) < 0; });
+
+        if (it == end || std::strcmp(it->name, name) != 0) return nullptr;
+        return it->handler;
+    }
+
+    JsonDocument call(JsonVariant request) {
+        // Name is compared in place, without copy
+        const char* method = request["method"].as<const char*>();
+        JsonArray args = request["args"].as<JsonArray>();
+
+        if (method) {
+            auto handler = find_static(method);
+            if (handler) return handler(args);
+
+            if (!functions.empty()) {
+                auto it = functions.find(method);
+                if (it != functions.end()) return it->second(args);
+            }
+        }
+
+        return jrcpd::create_response(false, "Method not found");
+    }
 };
@@ -9,8 +9,8 @@
 #include "auth_utils.hpp"
 #include "app.hpp"
 
-JsonRpcDispatcher rpc;
-JsonRpcDispatcher auth_rpc;
+// Defined at the end, with static methods tables
+extern JsonRpcDispatcher auth_rpc;
 
 namespace {
 
@@ -23,8 +23,10 @@ const char* SERVICE_UUID = "5f524546-4c4f-575f-5250-435f5356435f"; // _REFLOW_RP
 const char* RPC_CHARACTERISTIC_UUID = "5f524546-4c4f-575f-5250-435f494f5f5f"; // _REFLOW_RPC_IO__
 const char* AUTH_CHARACTERISTIC_UUID = "5f524546-4c4f-575f-5250-435f41555448"; // _REFLOW_RPC_AUTH
 
+constexpr PreferenceKey BLE_NAME_KEY{"settings", "ble_name"};
+
 auto bleAuthStore = BleAuthStore<4>(prefsKV);
-auto bleNameStore = AsyncPreference<std::string>(prefsKV, "settings", "ble_name", "Reflow Table");
+auto bleNameStore = AsyncPreference<std::string>(prefsKV, BLE_NAME_KEY, "Reflow Table");
 
 class Session;
 Session* context;
@@ -36,7 +38,8 @@ public:
     Session()
         : rpcChunker(16*1024 + 500), authChunker(1*1024), authenticated(false)
     {
-        rpcChunker.onMessage = [](const std::vector<uint8_t>& message) {
+        // Responses are serialized directly into outgoing chunks
+        rpcChunker.onMessageStream = [](const std::vector<uint8_t>& message, BleChunkWriter& writer) {
             size_t freeMemory = heap_caps_get_free_size(MALLOC_CAP_8BIT);
             size_t minimumFreeMemory = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
             DEBUG("Free memory: {} Minimum free memory: {}", uint32_t(freeMemory), uint32_t(minimumFreeMemory));
@@ -45,20 +48,15 @@ public:
 
             auto session = get_context();
             if (session && session->authenticated) {
-                std::vector<uint8_t> response;
-                rpc.dispatch(message, response);
-                return response;
+                rpc.dispatch(message, writer);
+                return;
             }
             
-            const std::string error_json = R"({"ok": false, "result": "Not authenticated"})";
-            const std::vector<uint8_t> error(error_json.begin(), error_json.end());
-            return error;
+            jrcpd::serialize_to(jrcpd::create_response(false, "Not authenticated"), writer, jrcpd::detect_format(message));
         };
 
-        authChunker.onMessage = [](const std::vector<uint8_t>& message) {
-            std::vector<uint8_t> response;
-            auth_rpc.dispatch(message, response);
-            return response;
+        authChunker.onMessageStream = [](const std::vector<uint8_t>& message, BleChunkWriter& writer) {
+            auth_rpc.dispatch(message, writer);
         };
 
         // No default value allowed!
@@ -156,6 +154,8 @@ public:
 void ble_init() {
     prefsWriter.add(bleAuthStore);
     prefsWriter.add(bleNameStore);
+    // Load everything now, to never touch flash on first access from BLE task
+    prefsWriter.preload(prefsKV);
 
     const std::string name = bleNameStore.get().substr(0, 20); // Limit name length
     NimBLEDevice::init(name);
@@ -266,20 +266,102 @@ std::string pair(const std::string str_client_id) {
     bleAuthStore.create(client_id, secret);
 
     // Exit pairing mode on success
-    app.receive(BondOff());
+    app.post(BondOff());
 
     return bin2hex(secret.data(), secret.size());
 }
 
+// Persistence stats of preferences, to find ones that churn flash
+std::string prefs_stats() {
+    JsonDocument doc;
+    JsonArray list = doc.to<JsonArray>();
+
+    prefsWriter.visitStats([&list](const PreferenceKey& key, const AsyncPreferenceStats& stats) {
+        JsonObject item = list.add<JsonObject>();
+        item["ns"] = key.ns;
+        item["name"] = key.name;
+        item["snapshots"] = stats.snapshots;
+        item["torn"] = stats.torn;
+        item["writes"] = stats.writes;
+        item["bytes"] = stats.bytes;
+        item["latency_max_us"] = stats.latency_max_us;
+        item["latency_avg_us"] = stats.latencyAvg();
+
+        JsonArray histogram = item["latency_histogram"].to<JsonArray>();
+        for (auto count : stats.latency_histogram) histogram.add(count);
+    });
+
+    std::string output;
+    serializeJson(doc, output);
+    return output;
+}
+
+// App FSM events trace and per-state handler stats
+std::string app_stats() {
+    JsonDocument doc;
+
+    JsonArray states = doc["states"].to<JsonArray>();
+    for (uint8_t id = 0; id < App::Tracer::MAX_STATES; id++) {
+        const auto stats = appTracer.getStateStats(id);
+        if (!stats.events) continue;
+
+        JsonObject item = states.add<JsonObject>();
+        item["id"] = id;
+        item["events"] = stats.events;
+        item["transitions"] = stats.transitions;
+        item["handler_max_us"] = stats.handler_max_us;
+        item["handler_avg_us"] = stats.handlerAvg();
+        item["queue_max_us"] = stats.queue_max_us;
+
+        JsonArray histogram = item["histogram"].to<JsonArray>();
+        for (auto count : stats.histogram) histogram.add(count);
+    }
+
+    App::Tracer::Record records[App::Tracer::RING_SIZE];
+    const size_t count = appTracer.getRecords(records, App::Tracer::RING_SIZE);
+
+    JsonArray trace = doc["trace"].to<JsonArray>();
+    for (size_t i = 0; i < count; i++) {
+        JsonObject item = trace.add<JsonObject>();
+        item["event"] = records[i].event_id;
+        item["from"] = records[i].from;
+        item["to"] = records[i].to;
+        item["queue_us"] = records[i].queue_us;
+        item["handler_us"] = records[i].handler_us;
+    }
+
+    std::string output;
+    serializeJson(doc, output);
+    return output;
+}
+
+// Demo methods, for ble_check_app
+std::string echo(const std::string msg) { return msg; }
+bool devnull(const std::string msg) { return true; }
+
+// Methods are known at compile time, so dispatchers use static tables
+// instead of registry on heap.
+constexpr auto AUTH_METHODS = jrcpd::make_methods(
+    jrcpd::method<auth_info>("auth_info"),
+    jrcpd::method<authenticate>("authenticate"),
+    jrcpd::method<pair>("pair")
+);
+
+constexpr auto RPC_METHODS = jrcpd::make_methods(
+    jrcpd::method<prefs_stats>("prefs_stats"),
+    jrcpd::method<app_stats>("app_stats"),
+    jrcpd::method<echo>("echo"),
+    jrcpd::method<devnull>("devnull")
+);
+
 }
 
+JsonRpcDispatcher rpc(RPC_METHODS);
+JsonRpcDispatcher auth_rpc(AUTH_METHODS);
+
 void pairing_enable() { pairing_enabled_flag = true; }
 void pairing_disable() { pairing_enabled_flag = false; }
 
 void rpc_init() {
-    auth_rpc.addMethod("auth_info", auth_info);
-    auth_rpc.addMethod("authenticate", authenticate);
-    auth_rpc.addMethod("pair", pair);
-
     ble_init();
 }
@@ -0,0 +1,40 @@
+#include <Arduino.h>
+#include "scheduler.hpp"
+
+Scheduler scheduler;
+
+namespace {
+
+TaskHandle_t scheduler_task = nullptr;
+
+void scheduler_thread(void* pvParameters) {
+    while (true) {
+        const uint32_t delay = scheduler.run(millis());
+
+        // Sleep until the nearest deadline or wake request. Without deadlines
+        // sleep forever, to let idle task enter light sleep.
+        ulTaskNotifyTake(pdTRUE, delay == Scheduler::NEVER ? portMAX_DELAY : pdMS_TO_TICKS(delay));
+    }
+}
+
+}
+
+void scheduler_wake(int job_id) {
+    scheduler.wake(job_id);
+    if (scheduler_task) xTaskNotifyGive(scheduler_task);
+}
+
+void IRAM_ATTR scheduler_wake_from_isr(int job_id) {
+    scheduler.wake(job_id);
+    if (!scheduler_task) return;
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(scheduler_task, &woken);
+    if (woken) portYIELD_FROM_ISR();
+}
+
+void scheduler_start() {
+    // Single stack for all engines. Priority is above prefs writer, to not
+    // wait for flash writes.
+    xTaskCreate(scheduler_thread, "scheduler", 1024 * 4, NULL, 2, &scheduler_task);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "utils/tick_scheduler.hpp"
+
+using Scheduler = TickScheduler<>;
+
+extern Scheduler scheduler;
+
+// Run job as soon as possible. Safe to call from any task.
+void scheduler_wake(int job_id);
+// IRAM-safe, can be called from IRAM ISR
+void scheduler_wake_from_isr(int job_id);
+// Start scheduler task. Call after all jobs are registered.
+void scheduler_start();
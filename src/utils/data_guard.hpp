@@ -1,16 +1,108 @@
 #pragma once
 
-#include <atomic>
+#include <cstddef>
 #include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include "seqlock.hpp"
 
-// Types store with lock-free writes and optimistic reads
+// Byte range of snapshot, changed by copy. `from == to` means no changes,
+// `all` means range is unknown and whole value should be treated as changed.
+struct DataGuardDirty {
+    size_t from = 0;
+    size_t to = 0;
+    bool all = false;
+
+    bool empty() const { return !all && from == to; }
+
+    void merge(const DataGuardDirty& other) {
+        if (other.all) all = true;
+        if (other.from == other.to) return;
+        if (from == to) { from = other.from; to = other.to; return; }
+        from = std::min(from, other.from);
+        to = std::max(to, other.to);
+    }
+};
+
+namespace data_guard_ns {
+
+// Copy only the span between first and last changed bytes
+inline void diff_copy(uint8_t* dst, const uint8_t* src, size_t size, DataGuardDirty& dirty) {
+    size_t from = 0;
+    while (from < size && dst[from] == src[from]) from++;
+
+    size_t to = size;
+    while (to > from && dst[to - 1] == src[to - 1]) to--;
+
+    if (from < to) std::memcpy(dst + from, src + from, to - from);
+    dirty = { from, to, false };
+}
+
+template <typename T, typename = void>
+struct IsPlainBuffer : std::false_type {};
+
+// Types with data(), size(), resize() and trivially copyable elements
+// (std::string, std::vector<POD>, and alike)
+template <typename T>
+struct IsPlainBuffer<T, std::void_t<decltype(std::declval<T>().data()),
+                                    decltype(std::declval<T>().size()),
+                                    decltype(std::declval<T>().resize(0)),
+                                    typename T::value_type>>
+    : std::is_trivially_copyable<typename T::value_type> {};
+
+}
+
+// Snapshot copy policy. Default is plain assignment with whole value marked
+// as changed. Specialize for own types to copy only modified parts.
+template <typename T, typename = void>
+struct DataGuardCopier {
+    static void copy(T& dst, const T& src, DataGuardDirty& dirty) {
+        dst = src;
+        dirty = { 0, 0, true };
+    }
+};
+
+// Trivially copyable types (PODs, std::array of PODs): update changed bytes only
+template <typename T>
+struct DataGuardCopier<T, std::enable_if_t<std::is_trivially_copyable<T>::value>> {
+    static void copy(T& dst, const T& src, DataGuardDirty& dirty) {
+        data_guard_ns::diff_copy(reinterpret_cast<uint8_t*>(&dst), reinterpret_cast<const uint8_t*>(&src), sizeof(T), dirty);
+    }
+};
+
+// Plain buffers: reuse destination capacity, and update changed bytes only.
+// Allocation happens only when value grows beyond snapshot capacity.
 template <typename T>
+struct DataGuardCopier<T, std::enable_if_t<!std::is_trivially_copyable<T>::value && data_guard_ns::IsPlainBuffer<T>::value>> {
+    static void copy(T& dst, const T& src, DataGuardDirty& dirty) {
+        constexpr size_t elem_size = sizeof(typename T::value_type);
+        const size_t old_size = dst.size() * elem_size;
+        const size_t new_size = src.size() * elem_size;
+
+        if (dst.size() != src.size()) dst.resize(src.size());
+
+        data_guard_ns::diff_copy(reinterpret_cast<uint8_t*>(dst.data()), reinterpret_cast<const uint8_t*>(src.data()), new_size, dirty);
+
+        // Size change affects tail
+        if (old_size != new_size) {
+            DataGuardDirty tail{ std::min(old_size, new_size), std::max(old_size, new_size), false };
+            dirty.merge(tail);
+        }
+    }
+};
+
+// Types store with lock-free writes and optimistic reads
+template <typename T, typename Copier = DataGuardCopier<T>>
 class DataGuard {
 public:
-    DataGuard(const T& initial = T()) : value{initial}, snapshot{}, data_version(0), last_snapshot_version(0) {}
+    DataGuard(const T& initial = T()) : value{initial}, snapshot{} {}
 
     T value;
     T snapshot;
+    // Part of snapshot, changed by the last successful makeSnapshot()
+    DataGuardDirty dirty;
 
     void writeData(const T& newValue) {
         beginWrite();
@@ -18,21 +110,48 @@ public:
         endWrite();
     }
 
+    // Take ownership of new value buffers instead of copying them
+    void writeData(T&& newValue) {
+        beginWrite();
+        value = std::move(newValue);
+        endWrite();
+    }
+
+    // Snapshot side helpers, to sync dirty tracking with external storage.
+    // Should not be called concurrently with makeSnapshot().
+    void markAllDirty() { pending.all = true; }
+
+    void syncSnapshot() {
+        snapshot = value;
+        pending = {};
+    }
+
+    // True if value was modified after the last successful snapshot
+    bool hasChanges() const { return counter.changedSince(snapshot_cursor); }
+
     // Guards for direct modifications of value inner
-    void beginWrite() { data_version.fetch_add(1, std::memory_order_release); }
-    void endWrite() { data_version.fetch_add(1, std::memory_order_relaxed); }
+    void beginWrite() { counter.beginWrite(); }
+    void endWrite() { counter.endWrite(); }
 
 
     // Atomic clone of the value
     bool makeSnapshot() {
-        const uint32_t version_before = data_version.load(std::memory_order_acquire);
+        const uint32_t version_before = counter.readBegin();
 
         // If version is odd, it means that value is being updated right now.
-        if (last_snapshot_version != version_before && version_before % 2 == 0) {
-            snapshot = value;
+        if (snapshot_cursor.version != version_before && version_before % 2 == 0) {
+            DataGuardDirty attempt;
+            Copier::copy(snapshot, value, attempt);
+
+            // Torn copy could modify snapshot too, keep that range until
+            // the next successful attempt.
+            pending.merge(attempt);
+
             // If version is still the same => snapshot is useable.
-            if (version_before == data_version.load(std::memory_order_acquire)) {
-                last_snapshot_version = version_before;
+            if (counter.readValidate(version_before)) {
+                snapshot_cursor.version = version_before;
+                dirty = pending;
+                pending = {};
                 return true;
             }
         }
@@ -41,6 +160,7 @@ public:
     }
 
 private:
-    std::atomic<uint32_t> data_version;
-    uint32_t last_snapshot_version;
-};
\ No newline at end of file
+    SeqLockCounter<> counter;
+    SeqLockCounter<>::Cursor snapshot_cursor;
+    DataGuardDirty pending;
+};
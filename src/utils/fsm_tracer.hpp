@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "log2_histogram.hpp"
+
+// Instrumentation for state machines. Keeps ring of the latest handled events
+// and per-state stats of handler durations, to catch slow handlers.
+// Records are added by dispatcher thread, and can be read from any thread.
+template <size_t MaxStates = 8, size_t RingSize = 32>
+class FsmTracer {
+public:
+    static constexpr size_t MAX_STATES = MaxStates;
+    static constexpr size_t RING_SIZE = RingSize;
+
+    // Handler durations, see `log2_bucket()`
+    static constexpr size_t HISTOGRAM_BUCKETS = 16;
+
+    struct Record {
+        uint32_t queue_us;   // From posting to handling start
+        uint32_t handler_us; // Handler duration, including state enter/exit
+        uint8_t event_id;
+        uint8_t from;
+        uint8_t to;
+    };
+
+    // Stats of events, handled in state (by source state)
+    struct StateStats {
+        uint32_t events = 0;
+        uint32_t transitions = 0;
+        uint32_t handler_max_us = 0;
+        uint32_t handler_total_us = 0;
+        uint32_t queue_max_us = 0;
+        uint32_t histogram[HISTOGRAM_BUCKETS] = {};
+
+        uint32_t handlerAvg() const { return events ? handler_total_us / events : 0; }
+    };
+
+    void record(const Record& rec) {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        ring[head] = rec;
+        head = (head + 1) % RingSize;
+        if (count < RingSize) count++;
+
+        if (rec.from >= MaxStates) return;
+
+        auto& stats = states[rec.from];
+        stats.events++;
+        if (rec.from != rec.to) stats.transitions++;
+        stats.handler_total_us += rec.handler_us;
+        if (rec.handler_us > stats.handler_max_us) stats.handler_max_us = rec.handler_us;
+        if (rec.queue_us > stats.queue_max_us) stats.queue_max_us = rec.queue_us;
+        stats.histogram[bucket(rec.handler_us)]++;
+    }
+
+    // Copy the latest records, oldest first. Returns number of copied ones.
+    size_t getRecords(Record* output, size_t max) const {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        const size_t n = count < max ? count : max;
+        const size_t first = (head + RingSize - n) % RingSize;
+        for (size_t i = 0; i < n; i++) output[i] = ring[(first + i) % RingSize];
+        return n;
+    }
+
+    StateStats getStateStats(uint8_t state) const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return state < MaxStates ? states[state] : StateStats{};
+    }
+
+    static constexpr size_t bucket(uint32_t us) { return log2_bucket(us, HISTOGRAM_BUCKETS); }
+
+private:
+    mutable std::mutex mutex;
+    Record ring[RingSize] = {};
+    size_t head = 0;
+    size_t count = 0;
+    StateStats states[MaxStates];
+};
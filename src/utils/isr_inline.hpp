@@ -0,0 +1,6 @@
+#pragma once
+
+// For methods, called from ISR. ISR lives in IRAM, and code inlined into it
+// goes there too. Out-of-line copies of templates are placed in flash, and
+// crash when flash cache is disabled (during NVS writes).
+#define ISR_INLINE inline __attribute__((always_inline))
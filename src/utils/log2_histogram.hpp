@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Bucket index for histograms of durations with power-of-2 bucket bounds.
+// Bucket N counts values of [2^N, 2^(N+1)), the last one is open-ended.
+// Values 0 and 1 go to bucket 0.
+constexpr size_t log2_bucket(uint32_t value, size_t buckets) {
+    size_t result = 0;
+    while (value > 1 && result < buckets - 1) { value >>= 1; result++; }
+    return result;
+}
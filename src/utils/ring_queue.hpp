@@ -0,0 +1,99 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "isr_inline.hpp"
+
+// Bounded lock-free queues with fixed storage. Size must be power of 2.
+// Both return false on overflow instead of blocking, so producers are safe to
+// call from ISR or from time-critical tasks. Push is force-inlined and uses
+// plain arrays only, to be IRAM-safe inside ISR.
+
+// Single producer, single consumer
+template <typename T, size_t Size>
+class SpscRingQueue {
+    static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "Size must be power of 2");
+
+public:
+    SpscRingQueue() : head(0), tail(0) {}
+
+    ISR_INLINE bool push(const T& value) {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= Size) return false;
+
+        buffer[h & (Size - 1)] = value;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& output) {
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+
+        output = buffer[t & (Size - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const { return tail.load(std::memory_order_acquire) == head.load(std::memory_order_acquire); }
+
+private:
+    T buffer[Size];
+    std::atomic<uint32_t> head; // Written by producer
+    std::atomic<uint32_t> tail; // Written by consumer
+};
+
+// Multiple producers, single consumer. Each cell has own sequence number
+// (D. Vyukov's bounded queue), so producers only contend on one counter and
+// consumer never sees partially written cells.
+template <typename T, size_t Size>
+class MpscRingQueue {
+    static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "Size must be power of 2");
+
+public:
+    MpscRingQueue() : head(0), tail(0) {
+        for (size_t i = 0; i < Size; i++) cells[i].sequence.store(uint32_t(i), std::memory_order_relaxed);
+    }
+
+    ISR_INLINE bool push(const T& value) {
+        uint32_t pos = head.load(std::memory_order_relaxed);
+
+        while (true) {
+            Cell& cell = cells[pos & (Size - 1)];
+            const int32_t diff = int32_t(cell.sequence.load(std::memory_order_acquire) - pos);
+
+            if (diff == 0) {
+                if (head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false; // Full
+            } else {
+                pos = head.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop(T& output) {
+        Cell& cell = cells[tail & (Size - 1)];
+        if (int32_t(cell.sequence.load(std::memory_order_acquire) - (tail + 1)) < 0) return false;
+
+        output = cell.value;
+        cell.sequence.store(tail + Size, std::memory_order_release);
+        tail++;
+        return true;
+    }
+
+private:
+    struct Cell {
+        std::atomic<uint32_t> sequence;
+        T value;
+    };
+
+    Cell cells[Size];
+    std::atomic<uint32_t> head;
+    uint32_t tail; // Owned by consumer
+};
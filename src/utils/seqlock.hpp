@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+// Sequence lock: lock-free optimistic reads of data, modified by writers.
+//
+// Writer makes version odd before modification and even after. Reader copies
+// data and accepts the copy only if version was even and did not change
+// meanwhile. Readers never block writers and do not modify shared state, so
+// any number of readers is allowed. Each reader keeps own cursor (last seen
+// version) to detect changes.
+//
+// Fences follow H.-J. Boehm, "Can Seqlocks Get Along With Programming
+// Language Memory Models?".
+
+// Version counter of the protocol, without data storage. Use directly when
+// data should live outside (see DataGuard).
+template <bool MultiWriter = false>
+class SeqLockCounter {
+public:
+    SeqLockCounter() : version(0) {}
+
+    // Per-reader state
+    struct Cursor {
+        uint32_t version = 0;
+    };
+
+    void beginWrite() {
+        if (MultiWriter) lockWriters();
+
+        version.fetch_add(1, std::memory_order_relaxed);
+        // Odd version must be visible before any data modification
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    void endWrite() {
+        version.fetch_add(1, std::memory_order_release);
+
+        if (MultiWriter) writer_lock.clear(std::memory_order_release);
+    }
+
+    // Returns version to pass into readValidate(). Odd value means write in
+    // progress, and copy will be rejected.
+    uint32_t readBegin() const { return version.load(std::memory_order_acquire); }
+
+    bool readValidate(uint32_t version_before) const {
+        // Data loads must complete before version re-check
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return version_before % 2 == 0 && version_before == version.load(std::memory_order_relaxed);
+    }
+
+    bool changedSince(const Cursor& cursor) const { return readBegin() != cursor.version; }
+
+    uint32_t current() const { return readBegin(); }
+
+private:
+    std::atomic<uint32_t> version;
+    std::atomic_flag writer_lock = ATOMIC_FLAG_INIT;
+
+    // Writers are short, so spin first. Then sleep, to let preempted
+    // lower-priority writer finish (yield does not help with that on RTOS).
+    void lockWriters() {
+        uint32_t attempts = 0;
+        while (writer_lock.test_and_set(std::memory_order_acquire)) {
+            if (++attempts < 100) std::this_thread::yield();
+            else std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    }
+};
+
+// Value protected by seqlock
+template <typename T, bool MultiWriter = false>
+class SeqLock {
+public:
+    using Cursor = typename SeqLockCounter<MultiWriter>::Cursor;
+
+    SeqLock(const T& initial = T()) : data{initial} {}
+
+    void write(const T& value) {
+        counter.beginWrite();
+        data = value;
+        counter.endWrite();
+    }
+
+    // Single attempt to copy data, if changed since cursor. Returns false if
+    // nothing new or write is in progress (retry later).
+    bool tryRead(T& output, Cursor& cursor) const {
+        const uint32_t version_before = counter.readBegin();
+        if (version_before == cursor.version || version_before % 2 != 0) return false;
+
+        T temp = data;
+        if (!counter.readValidate(version_before)) return false;
+
+        output = temp;
+        cursor.version = version_before;
+        return true;
+    }
+
+    // Spin until consistent copy received
+    T read() const {
+        while (true) {
+            const uint32_t version_before = counter.readBegin();
+            if (version_before % 2 != 0) { std::this_thread::yield(); continue; }
+
+            T temp = data;
+            if (counter.readValidate(version_before)) return temp;
+        }
+    }
+
+    bool changedSince(const Cursor& cursor) const { return counter.changedSince(cursor); }
+
+private:
+    SeqLockCounter<MultiWriter> counter;
+    T data;
+};
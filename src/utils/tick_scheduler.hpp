@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "isr_inline.hpp"
+
+// Cooperative scheduler for tick-based engines, to run them all from single
+// task. Each job returns delay (ms) until the next run, and the task sleeps
+// until the earliest deadline. NEVER means "no work until woken".
+//
+// Jobs are few, so deadlines are kept in flat array and scanned linearly.
+// That's cheaper than timer wheel for such sizes.
+template <size_t MaxJobs = 8>
+class TickScheduler {
+public:
+    static_assert(MaxJobs <= 32, "Wake mask supports up to 32 jobs");
+
+    static constexpr uint32_t NEVER = UINT32_MAX;
+
+    // Receives current time, returns delay until the next run or NEVER
+    using Job = uint32_t (*)(uint32_t now);
+
+    TickScheduler() : count(0), wake_mask(0) {}
+
+    // Returns job id for `wake()`, or -1 if no free slots. Job runs at the
+    // first `run()`. Not thread safe, add all jobs before start.
+    int add(Job job) {
+        if (count >= MaxJobs) return -1;
+        const int id = int(count++);
+        jobs[id] = { job, 0, false };
+        wake(id);
+        return id;
+    }
+
+    // Request job run at the next `run()`. Safe to call from any thread and
+    // from ISR (inlined into caller). Caller should also wake the scheduler
+    // task, if it sleeps.
+    ISR_INLINE void wake(int id) {
+        if (id < 0 || size_t(id) >= count) return;
+        wake_mask.fetch_or(1u << id, std::memory_order_release);
+    }
+
+    // Run due jobs. Returns delay until the nearest deadline or NEVER.
+    uint32_t run(uint32_t now) {
+        const uint32_t woken = wake_mask.exchange(0, std::memory_order_acquire);
+        uint32_t next = NEVER;
+
+        for (size_t i = 0; i < count; i++) {
+            auto& job = jobs[i];
+
+            if ((woken & (1u << i)) || (job.active && isDue(job.deadline, now))) {
+                const uint32_t delay = job.fn(now);
+                job.active = delay != NEVER;
+                job.deadline = now + delay;
+            }
+
+            if (!job.active) continue;
+
+            const uint32_t left = isDue(job.deadline, now) ? 0 : job.deadline - now;
+            if (left < next) next = left;
+        }
+
+        return next;
+    }
+
+private:
+    struct Entry {
+        Job fn;
+        uint32_t deadline;
+        bool active;
+    };
+
+    Entry jobs[MaxJobs];
+    size_t count;
+    std::atomic<uint32_t> wake_mask;
+
+    // Overflow-safe deadline check
+    static bool isDue(uint32_t deadline, uint32_t now) { return int32_t(deadline - now) <= 0; }
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Wait-free triple buffer for single producer and single consumer, with
+// "latest value wins" semantic. Writer fills back buffer and publishes it by
+// swapping with middle one. Reader takes middle buffer only if it has fresh
+// data. Nobody waits, and no copy is made on exchange.
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer(const T& initial = T()) : buffers{initial, initial, initial}, middle(1), back(2), front(0) {}
+
+    // Producer side: fill writeBuffer() then call publish(),
+    // or use write() for a copy.
+    T& writeBuffer() { return buffers[back]; }
+
+    void publish() {
+        const uint8_t prev = middle.exchange(back | FRESH_FLAG, std::memory_order_acq_rel);
+        back = prev & INDEX_MASK;
+    }
+
+    void write(const T& value) {
+        writeBuffer() = value;
+        publish();
+    }
+
+    // Consumer side. Returns true if new data became available since the
+    // previous call. Data is available via readBuffer().
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & FRESH_FLAG)) return false;
+
+        const uint8_t prev = middle.exchange(front, std::memory_order_acq_rel);
+        front = prev & INDEX_MASK;
+        return true;
+    }
+
+    const T& readBuffer() const { return buffers[front]; }
+
+    bool read(T& output) {
+        if (!update()) return false;
+        output = readBuffer();
+        return true;
+    }
+
+private:
+    static constexpr uint8_t FRESH_FLAG = 0x80;
+    static constexpr uint8_t INDEX_MASK = 0x03;
+
+    std::array<T, 3> buffers;
+    std::atomic<uint8_t> middle; // Index + fresh flag
+    uint8_t back;  // Owned by producer
+    uint8_t front; // Owned by consumer
+};
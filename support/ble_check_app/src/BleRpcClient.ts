@@ -27,7 +27,8 @@ export class BleRpcClient {
     private rpcIO = new BleCharacteristicIO();
     private authIO = new BleCharacteristicIO();
 
-    private rpcCaller = new RpcCaller(new BleClientChunker(this.rpcIO));
+    // Main channel carries bulk data, use compact binary format there
+    private rpcCaller = new RpcCaller(new BleClientChunker(this.rpcIO), { format: 'msgpack' });
     private authCaller = new RpcCaller(new BleClientChunker(this.authIO));
 
     private authStorage = new AuthStorage();
@@ -0,0 +1,212 @@
+// Minimal MessagePack encoder / decoder, for RPC messages. Supports nil,
+// booleans, numbers, strings, binary, arrays and maps (plain objects).
+// Extension types are not used by firmware and not supported.
+
+export type MsgPackValue = null | boolean | number | string | Uint8Array |
+    MsgPackValue[] | { [key: string]: MsgPackValue };
+
+const MAX_SAFE_INTEGER = 9007199254740991;
+
+// JSON request/response is an object and starts with `{`. MessagePack map
+// or array header can never start JSON text.
+export function isMsgPack(data: Uint8Array): boolean {
+    if (data.length === 0) return false;
+    const first = data[0];
+    return (first >= 0x80 && first <= 0x9f) || (first >= 0xdc && first <= 0xdf);
+}
+
+class Encoder {
+    private buffer = new Uint8Array(256);
+    private view = new DataView(this.buffer.buffer);
+    private pos = 0;
+
+    private ensure(size: number) {
+        if (this.pos + size <= this.buffer.length) return;
+
+        let length = this.buffer.length * 2;
+        while (length < this.pos + size) length *= 2;
+
+        const buffer = new Uint8Array(length);
+        buffer.set(this.buffer.subarray(0, this.pos));
+        this.buffer = buffer;
+        this.view = new DataView(buffer.buffer);
+    }
+
+    private u8(value: number) { this.ensure(1); this.view.setUint8(this.pos, value); this.pos += 1; }
+    private u16(value: number) { this.ensure(2); this.view.setUint16(this.pos, value); this.pos += 2; }
+    private u32(value: number) { this.ensure(4); this.view.setUint32(this.pos, value); this.pos += 4; }
+
+    private bytes(data: Uint8Array) {
+        this.ensure(data.length);
+        this.buffer.set(data, this.pos);
+        this.pos += data.length;
+    }
+
+    private header(length: number, fix: number, fixMax: number, codes: [number, number, number]) {
+        if (length <= fixMax && fix >= 0) this.u8(fix | length);
+        else if (length <= 0xff && codes[0] >= 0) { this.u8(codes[0]); this.u8(length); }
+        else if (length <= 0xffff) { this.u8(codes[1]); this.u16(length); }
+        else { this.u8(codes[2]); this.u32(length); }
+    }
+
+    // 64-bit values as two 32-bit halves, to stay within ES5 (no BigInt)
+    private u64(value: number) {
+        const high = Math.floor(value / 0x100000000);
+        this.u32(high >>> 0);
+        this.u32((value - high * 0x100000000) >>> 0);
+    }
+
+    private number(value: number) {
+        if (Math.floor(value) === value && Math.abs(value) <= MAX_SAFE_INTEGER) {
+            if (value >= 0) {
+                if (value < 0x80) this.u8(value);
+                else if (value <= 0xff) { this.u8(0xcc); this.u8(value); }
+                else if (value <= 0xffff) { this.u8(0xcd); this.u16(value); }
+                else if (value <= 0xffffffff) { this.u8(0xce); this.u32(value); }
+                else { this.u8(0xcf); this.u64(value); }
+            } else {
+                if (value >= -32) this.u8(value & 0xff);
+                else if (value >= -0x80) { this.u8(0xd0); this.ensure(1); this.view.setInt8(this.pos, value); this.pos += 1; }
+                else if (value >= -0x8000) { this.u8(0xd1); this.ensure(2); this.view.setInt16(this.pos, value); this.pos += 2; }
+                else if (value >= -0x80000000) { this.u8(0xd2); this.ensure(4); this.view.setInt32(this.pos, value); this.pos += 4; }
+                else { this.u8(0xd3); this.u64(value); }
+            }
+            return;
+        }
+
+        this.u8(0xcb);
+        this.ensure(8);
+        this.view.setFloat64(this.pos, value);
+        this.pos += 8;
+    }
+
+    value(value: MsgPackValue) {
+        if (value === null || value === undefined) { this.u8(0xc0); return; }
+        if (value === false) { this.u8(0xc2); return; }
+        if (value === true) { this.u8(0xc3); return; }
+        if (typeof value === 'number') { this.number(value); return; }
+
+        if (typeof value === 'string') {
+            const data = new TextEncoder().encode(value);
+            this.header(data.length, 0xa0, 31, [0xd9, 0xda, 0xdb]);
+            this.bytes(data);
+            return;
+        }
+
+        if (value instanceof Uint8Array) {
+            this.header(value.length, -1, -1, [0xc4, 0xc5, 0xc6]);
+            this.bytes(value);
+            return;
+        }
+
+        if (Array.isArray(value)) {
+            this.header(value.length, 0x90, 15, [-1, 0xdc, 0xdd]);
+            for (const item of value) this.value(item);
+            return;
+        }
+
+        const map = value;
+        const keys = Object.keys(map).filter(key => map[key] !== undefined);
+        this.header(keys.length, 0x80, 15, [-1, 0xde, 0xdf]);
+        for (const key of keys) {
+            this.value(key);
+            this.value(map[key]);
+        }
+    }
+
+    result(): Uint8Array { return this.buffer.slice(0, this.pos); }
+}
+
+class Decoder {
+    private view: DataView;
+    private pos = 0;
+
+    constructor(private data: Uint8Array) {
+        this.view = new DataView(data.buffer, data.byteOffset, data.byteLength);
+    }
+
+    private need(size: number) {
+        if (this.pos + size > this.data.length) throw new Error('MsgPack: unexpected end of data');
+    }
+
+    private u8() { this.need(1); return this.view.getUint8(this.pos++); }
+    private u16() { this.need(2); const v = this.view.getUint16(this.pos); this.pos += 2; return v; }
+    private u32() { this.need(4); const v = this.view.getUint32(this.pos); this.pos += 4; return v; }
+
+    private bytes(length: number): Uint8Array {
+        this.need(length);
+        const result = this.data.subarray(this.pos, this.pos + length);
+        this.pos += length;
+        return result;
+    }
+
+    private str(length: number): string { return new TextDecoder().decode(this.bytes(length)); }
+
+    private array(length: number): MsgPackValue[] {
+        const result: MsgPackValue[] = [];
+        for (let i = 0; i < length; i++) result.push(this.value());
+        return result;
+    }
+
+    private map(length: number): { [key: string]: MsgPackValue } {
+        const result: { [key: string]: MsgPackValue } = {};
+        for (let i = 0; i < length; i++) {
+            const key = this.value();
+            result[String(key)] = this.value();
+        }
+        return result;
+    }
+
+    value(): MsgPackValue {
+        const code = this.u8();
+
+        if (code < 0x80) return code;
+        if (code >= 0xe0) return code - 0x100;
+        if ((code & 0xe0) === 0xa0) return this.str(code & 0x1f);
+        if ((code & 0xf0) === 0x90) return this.array(code & 0x0f);
+        if ((code & 0xf0) === 0x80) return this.map(code & 0x0f);
+
+        switch (code) {
+            case 0xc0: return null;
+            case 0xc2: return false;
+            case 0xc3: return true;
+            case 0xc4: return this.bytes(this.u8()).slice();
+            case 0xc5: return this.bytes(this.u16()).slice();
+            case 0xc6: return this.bytes(this.u32()).slice();
+            case 0xca: { this.need(4); const v = this.view.getFloat32(this.pos); this.pos += 4; return v; }
+            case 0xcb: { this.need(8); const v = this.view.getFloat64(this.pos); this.pos += 8; return v; }
+            case 0xcc: return this.u8();
+            case 0xcd: return this.u16();
+            case 0xce: return this.u32();
+            case 0xcf: { const high = this.u32(); return high * 0x100000000 + this.u32(); }
+            case 0xd0: { this.need(1); const v = this.view.getInt8(this.pos); this.pos += 1; return v; }
+            case 0xd1: { this.need(2); const v = this.view.getInt16(this.pos); this.pos += 2; return v; }
+            case 0xd2: { this.need(4); const v = this.view.getInt32(this.pos); this.pos += 4; return v; }
+            case 0xd3: { this.need(4); const high = this.view.getInt32(this.pos); this.pos += 4; return high * 0x100000000 + this.u32(); }
+            case 0xd9: return this.str(this.u8());
+            case 0xda: return this.str(this.u16());
+            case 0xdb: return this.str(this.u32());
+            case 0xdc: return this.array(this.u16());
+            case 0xdd: return this.array(this.u32());
+            case 0xde: return this.map(this.u16());
+            case 0xdf: return this.map(this.u32());
+        }
+
+        throw new Error(`MsgPack: unsupported type 0x${code.toString(16)}`);
+    }
+
+    end(): boolean { return this.pos === this.data.length; }
+}
+
+export function encode(value: MsgPackValue): Uint8Array {
+    const encoder = new Encoder();
+    encoder.value(value);
+    return encoder.result();
+}
+
+export function decode(data: Uint8Array): MsgPackValue {
+    const decoder = new Decoder(data);
+    const result = decoder.value();
+    if (!decoder.end()) throw new Error('MsgPack: extra data after value');
+    return result;
+}
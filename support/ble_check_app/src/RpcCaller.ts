@@ -1,39 +1,102 @@
 import { BinaryTransport } from './BleClientChunker';
+import * as MsgPack from './MsgPack';
 
 type RpcArgument = boolean | number | string;
 type RpcResult = boolean | number | string;
 
+// Wire format of requests. Device replies in the format of request.
+export type RpcFormat = 'json' | 'msgpack';
+
+export interface RpcCallerOptions {
+    format?: RpcFormat;
+    // Calls, issued in the same tick, are sent as one message (array of
+    // requests). Limit keeps device response buffer small.
+    maxBatch?: number;
+}
+
+interface RpcRequest {
+    method: string;
+    args: RpcArgument[];
+}
+
+interface PendingCall {
+    request: RpcRequest;
+    resolve: (result: RpcResult) => void;
+    reject: (error: Error) => void;
+}
+
 export class RpcCaller {
     private transport: BinaryTransport;
     private queue: Promise<void> = Promise.resolve();
+    private format: RpcFormat;
+    private maxBatch: number;
+    private pending: PendingCall[] = [];
 
-    constructor(transport: BinaryTransport) {
+    constructor(transport: BinaryTransport, options: RpcCallerOptions = {}) {
         this.transport = transport;
+        this.format = options.format ?? 'json';
+        this.maxBatch = options.maxBatch ?? 16;
     }
 
-    /**
-     * Invokes an RPC method with the given arguments.
-     */
-    async invoke(method: string, ...args: RpcArgument[]): Promise<RpcResult> {
-        const request = { method, args };
-        const requestData = new TextEncoder().encode(JSON.stringify(request));
-
-        // Chain the requests to ensure sequential processing
-        const resultPromise = this.queue.then(async () => {
-            const responseData = await this.transport.send(requestData);
-            const responseText = new TextDecoder().decode(responseData);
-            const response = JSON.parse(responseText);
-
-            if (response.ok !== true) {
-                throw new Error(`RPC Error: ${response.result}`);
+    private encode(request: RpcRequest | RpcRequest[]): Uint8Array {
+        if (this.format === 'msgpack') return MsgPack.encode(request as any);
+        return new TextEncoder().encode(JSON.stringify(request));
+    }
+
+    // Detect by content, because some errors may come in JSON anyway
+    private decode(data: Uint8Array): any {
+        if (MsgPack.isMsgPack(data)) return MsgPack.decode(data);
+        return JSON.parse(new TextDecoder().decode(data));
+    }
+
+    private settle(call: PendingCall, response: any) {
+        if (response && response.ok === true) call.resolve(response.result as RpcResult);
+        else call.reject(new Error(`RPC Error: ${response ? response.result : 'no response'}`));
+    }
+
+    // Single call is sent as object, to stay compatible with old firmware.
+    // Several calls go as array, and device replies with array of results.
+    private async send(calls: PendingCall[]) {
+        try {
+            const batch = calls.length > 1;
+            const requestData = this.encode(batch ? calls.map(call => call.request) : calls[0].request);
+            const response = this.decode(await this.transport.send(requestData));
+
+            if (!batch) {
+                this.settle(calls[0], response);
+                return;
             }
 
-            return response.result as RpcResult;
-        });
+            // Error for the whole message (not authenticated, parse failure)
+            if (!Array.isArray(response)) {
+                calls.forEach(call => this.settle(call, response));
+                return;
+            }
+
+            calls.forEach((call, i) => this.settle(call, response[i]));
+        } catch (error) {
+            calls.forEach(call => call.reject(error as Error));
+        }
+    }
+
+    private flush() {
+        while (this.pending.length > 0) {
+            const calls = this.pending.splice(0, this.maxBatch);
+            // Chain the requests to ensure sequential processing
+            this.queue = this.queue.then(() => this.send(calls));
+        }
+    }
 
-        // Update the queue to reflect the current operation
-        this.queue = resultPromise.then(() => {}).catch(() => {});
+    /**
+     * Invokes an RPC method with the given arguments. Calls made in the same
+     * tick are batched into a single message.
+     */
+    invoke(method: string, ...args: RpcArgument[]): Promise<RpcResult> {
+        return new Promise<RpcResult>((resolve, reject) => {
+            this.pending.push({ request: { method, args }, resolve, reject });
 
-        return resultPromise;
+            // Collect the rest of calls from the current tick first
+            if (this.pending.length === 1) Promise.resolve().then(() => this.flush());
+        });
     }
 }
@@ -0,0 +1,41 @@
+import { test } from 'node:test';
+import { strict as assert } from 'assert';
+import { encode, decode, isMsgPack } from '../src/MsgPack';
+import { bin } from './helpers';
+
+test('MsgPack should encode request as firmware expects', () => {
+    assert.deepEqual(
+        encode({ method: 'add', args: [1, 2] }),
+        bin(0x82, 0xa6, [...new TextEncoder().encode('method')], 0xa3, [...new TextEncoder().encode('add')],
+            0xa4, [...new TextEncoder().encode('args')], 0x92, 0x01, 0x02)
+    );
+});
+
+test('MsgPack should roundtrip all supported types', () => {
+    const values = [
+        null, true, false,
+        0, 127, 128, 255, 256, 65535, 65536, 0xffffffff, 2 ** 40,
+        -1, -32, -33, -128, -129, -32768, -32769, -(2 ** 31), -(2 ** 40),
+        1.5, -0.25,
+        '', 'hello', 'тест', 'x'.repeat(31), 'x'.repeat(32), 'x'.repeat(300), 'x'.repeat(70000),
+        new Uint8Array([1, 2, 3]),
+        [], [1, 'a', [true]], new Array(20).fill(7),
+        {}, { a: 1, b: { c: 'd' } }
+    ];
+
+    for (const value of values) {
+        assert.deepEqual(decode(encode(value)), value);
+    }
+});
+
+test('MsgPack should reject truncated data', () => {
+    const data = encode({ method: 'add', args: [1, 2] });
+    assert.throws(() => decode(data.slice(0, data.length - 1)));
+});
+
+test('MsgPack should be told apart from JSON by first byte', () => {
+    assert.equal(isMsgPack(encode({ ok: true })), true);
+    assert.equal(isMsgPack(encode([1])), true);
+    assert.equal(isMsgPack(new TextEncoder().encode('{"ok":true}')), false);
+    assert.equal(isMsgPack(new Uint8Array(0)), false);
+});
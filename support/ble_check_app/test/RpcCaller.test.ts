@@ -2,6 +2,7 @@ import { test } from 'node:test';
 import { strict as assert } from 'assert';
 import { RpcCaller } from '../src/RpcCaller';
 import { BinaryTransport } from '../src/BleClientChunker';
+import { encode, decode } from '../src/MsgPack';
 
 function s2bin(str: string): Uint8Array {
     return new TextEncoder().encode(str);
@@ -96,3 +97,71 @@ test('RpcCaller should handle unicode characters correctly', async () => {
     assert.strictEqual(writes.length, 1);
     assert.deepStrictEqual(writes[0], s2bin('{"method":"unicodeMethod","args":["тест"]}'));
 });
+
+test('RpcCaller should send and receive MessagePack', async () => {
+    const transport = new MockTransport([encode({ ok: true, result: 'success' })]);
+    const rpcClient = new RpcCaller(transport, { format: 'msgpack' });
+
+    const result = await rpcClient.invoke('anotherMethod', true, 123, 'test');
+
+    assert.strictEqual(result, 'success');
+    assert.deepStrictEqual(decode(transport.getWrites()[0]), { method: 'anotherMethod', args: [true, 123, 'test'] });
+});
+
+test('RpcCaller should accept JSON errors in MessagePack mode', async () => {
+    const transport = new MockTransport([s2bin('{"ok": false, "result": "Not authenticated"}')]);
+    const rpcClient = new RpcCaller(transport, { format: 'msgpack' });
+
+    await assert.rejects(
+        async () => { await rpcClient.invoke('someMethod'); },
+        new Error('RPC Error: Not authenticated')
+    );
+});
+
+// Result or error message, to check mixed outcomes of batch
+function outcome(promise: Promise<unknown>): Promise<unknown> {
+    return promise.then(value => ({ value }), (error: Error) => ({ error: error.message }));
+}
+
+test('RpcCaller should batch calls made in the same tick', async () => {
+    const transport = new MockTransport([s2bin('[{"ok": true, "result": 1}, {"ok": false, "result": "Oops"}, {"ok": true, "result": "c"}]')]);
+    const rpcClient = new RpcCaller(transport);
+
+    const results = await Promise.all([
+        outcome(rpcClient.invoke('a', 1)),
+        outcome(rpcClient.invoke('b')),
+        outcome(rpcClient.invoke('c', 'x'))
+    ]);
+
+    assert.deepStrictEqual(results, [{ value: 1 }, { error: 'RPC Error: Oops' }, { value: 'c' }]);
+
+    const writes = transport.getWrites();
+    assert.strictEqual(writes.length, 1);
+    assert.deepStrictEqual(writes[0], s2bin('[{"method":"a","args":[1]},{"method":"b","args":[]},{"method":"c","args":["x"]}]'));
+});
+
+test('RpcCaller should split batches by limit', async () => {
+    const transport = new MockTransport([
+        encode([{ ok: true, result: 1 }, { ok: true, result: 2 }]),
+        encode({ ok: true, result: 3 })
+    ]);
+    const rpcClient = new RpcCaller(transport, { format: 'msgpack', maxBatch: 2 });
+
+    const results = await Promise.all([rpcClient.invoke('a'), rpcClient.invoke('b'), rpcClient.invoke('c')]);
+
+    assert.deepStrictEqual(results, [1, 2, 3]);
+
+    const writes = transport.getWrites();
+    assert.strictEqual(writes.length, 2);
+    assert.deepStrictEqual(decode(writes[0]), [{ method: 'a', args: [] }, { method: 'b', args: [] }]);
+    assert.deepStrictEqual(decode(writes[1]), { method: 'c', args: [] });
+});
+
+test('RpcCaller should reject whole batch on message level error', async () => {
+    const transport = new MockTransport([s2bin('{"ok": false, "result": "Not authenticated"}')]);
+    const rpcClient = new RpcCaller(transport);
+
+    const results = await Promise.all([outcome(rpcClient.invoke('a')), outcome(rpcClient.invoke('b'))]);
+
+    assert.deepStrictEqual(results, [{ error: 'RPC Error: Not authenticated' }, { error: 'RPC Error: Not authenticated' }]);
+});
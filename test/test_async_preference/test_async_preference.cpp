@@ -1,28 +1,69 @@
 #include <gtest/gtest.h>
 #include <cstring>
+#include <atomic>
+#include <thread>
+#include "etl/array.h"
+#include "etl/string.h"
+#include "etl/vector.h"
 #include "async_preference/async_preference.hpp"
 
 // Mock class for IAsyncPreferenceKV
 class MockAsyncPreferenceKV : public IAsyncPreferenceKV {
 public:
-    // Simulate actual storage
+    // Simulate actual storage, indexed by full key name (hash may collide)
     std::map<std::string, std::vector<uint8_t>> storage;
 
-    void write(const std::string& ns, const std::string& key, uint8_t* buffer, size_t length) override {
+    static std::string id(const PreferenceKey& key) {
+        char name[32];
+        key.fullName(name, sizeof(name));
+        return std::string(key.ns) + '\0' + name;
+    }
+    size_t writes = 0;
+
+    void write(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
         std::vector<uint8_t> data(buffer, buffer + length);
-        storage[ns + key] = data;
+        storage[id(key)] = data;
+        writes++;
     }
 
-    void read(const std::string& ns, const std::string& key, uint8_t* buffer, size_t length) override {
-        const auto& data = storage[ns + key];
+    void read(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+        const auto& data = storage[id(key)];
         std::memcpy(buffer, data.data(), length);
     }
 
-    size_t length(const std::string& ns, const std::string& key) override {
-        return storage.count(ns + key) ? storage[ns + key].size() : 0;
+    size_t length(const PreferenceKey& key) override {
+        lengths++;
+        return storage.count(id(key)) ? storage[id(key)].size() : 0;
     }
+
+    void remove(const PreferenceKey& key) override { storage.erase(id(key)); }
+
+    // Track batches, as sequence of namespaces
+    std::vector<std::string> batches;
+    size_t lengths = 0;
+
+    void batchBegin(const char* ns) override { batches.push_back(ns); }
 };
 
+TEST(AsyncPreferenceTest, PreferenceKeyHash) {
+    // Should be computed at compile time
+    constexpr PreferenceKey key("ns", "key");
+    static_assert(key.hash == PreferenceKey::hashOf("ns", "key"), "Hash should be constexpr");
+
+    // Namespace & name should not be mixed
+    EXPECT_NE(PreferenceKey("ns1", "key").hash, PreferenceKey("ns", "1key").hash);
+    EXPECT_NE(PreferenceKey("ns", "key1").hash, PreferenceKey("ns", "key2").hash);
+
+    // Should be usable directly by AsyncPreference
+    MockAsyncPreferenceKV kv;
+    AsyncPreference<int32_t> pref(kv, key, 5);
+    pref.set(7);
+    pref.tick();
+
+    AsyncPreference<int32_t> pref2(kv, "ns", "key");
+    EXPECT_EQ(pref2.get(), 7);
+}
+
 // Trivially copyable type (int32_t)
 TEST(AsyncPreferenceTest, TriviallyCopyable_Int32) {
     MockAsyncPreferenceKV kv;
@@ -30,13 +71,13 @@ TEST(AsyncPreferenceTest, TriviallyCopyable_Int32) {
     AsyncPreference<int32_t> pref(kv, "ns", "key", -567);
 
     // Should use default when key not exists
-    EXPECT_EQ(kv.length("ns", "key"), size_t(0));
+    EXPECT_EQ(kv.length({"ns", "key"}), size_t(0));
     EXPECT_EQ(pref.get(), -567);
 
     // Should load from store when key available
     pref.set(123);
     pref.tick(); // Should save the snapshot
-    EXPECT_EQ(kv.length("ns", "key"), sizeof(int32_t));
+    EXPECT_EQ(kv.length({"ns", "key"}), sizeof(int32_t));
 
     AsyncPreference<int32_t> pref2(kv, "ns", "key", -567);
     EXPECT_EQ(pref2.get(), 123);
@@ -73,7 +114,7 @@ TEST(AsyncPreferenceTest, TriviallyCopyable_ArrayOfStructs) {
 
     pref.set(data);
     pref.tick(); // Trigger snapshot save
-    EXPECT_EQ(kv.length("ns", "key"), sizeof(TestArray));
+    EXPECT_EQ(kv.length({"ns", "key"}), sizeof(TestArray));
 
     // Should load from store
     AsyncPreference<TestArray> pref2(kv, "ns", "key");
@@ -109,7 +150,7 @@ TEST(AsyncPreferenceTest, BufferLikeCopyable_String) {
 
     // Should use default when key not exists
     AsyncPreference<std::string> pref2(kv, "ns", "key", "default");
-    EXPECT_EQ(kv.length("ns", "key"), size_t(0));
+    EXPECT_EQ(kv.length({"ns", "key"}), size_t(0));
     EXPECT_EQ(pref2.get(), "default");
 
     // Should load from store when key available
@@ -131,7 +172,7 @@ TEST(AsyncPreferenceTest, BufferLikeCopyable_Vector) {
     // Should use default when key not exists
     std::vector<uint32_t> default_data = { 1001, 1002, 1003 };
     AsyncPreference<std::vector<uint32_t>> pref2(kv, "ns", "key", default_data);
-    EXPECT_EQ(kv.length("ns", "key"), size_t(0));
+    EXPECT_EQ(kv.length({"ns", "key"}), size_t(0));
     EXPECT_EQ(pref2.get(), default_data);
 
     // Should load from store when key available
@@ -143,6 +184,608 @@ TEST(AsyncPreferenceTest, BufferLikeCopyable_Vector) {
     EXPECT_EQ(pref3.get(), data);
 }
 
+TEST(AsyncPreferenceTest, PageKeyHash) {
+    constexpr PreferenceKey key("ns", "key");
+
+    // Should match plain key with suffixed name
+    EXPECT_EQ(key.pageKey(0).hash, PreferenceKey("ns", "key.0").hash);
+    EXPECT_EQ(key.pageKey(12).hash, PreferenceKey("ns", "key.12").hash);
+
+    char name[16];
+    EXPECT_TRUE(key.pageKey(12).fullName(name, sizeof(name)));
+    EXPECT_STREQ(name, "key.12");
+}
+
+TEST(AsyncPreferenceTest, PageKeyNameLimit) {
+    constexpr PreferenceKey key("ns", "twelve_chars");
+    static_assert(key.pageKey(9).nameLength() == 14, "Name length should be constexpr");
+    static_assert(key.fitsPages(100), "Up to \"twelve_chars.99\" fits");
+    static_assert(!key.fitsPages(101), "\"twelve_chars.100\" is too long");
+    static_assert(!PreferenceKey("ns", "sixteen_chars_xx").fitsPages(0), "Base name is too long");
+
+    char name[PreferenceKey::MAX_NAME_LENGTH + 1];
+    EXPECT_TRUE(key.pageKey(99).fullName(name, sizeof(name)));
+    EXPECT_FALSE(key.pageKey(100).fullName(name, sizeof(name)));
+
+    // Too long page names are not written at all
+    MockAsyncPreferenceKV kv;
+    using Serializer = async_preference_ns::PagedSerializer<std::vector<uint8_t>, 1>;
+    Serializer::save(kv, key, std::vector<uint8_t>(101, 1));
+    EXPECT_TRUE(kv.storage.empty());
+
+    Serializer::save(kv, key, std::vector<uint8_t>(100, 1));
+    EXPECT_EQ(kv.storage.size(), size_t(101));
+}
+
+using PagedArray = std::array<uint32_t, 64>; // 4 pages of 64 bytes
+using PagedArraySerializer = async_preference_ns::PagedSerializer<PagedArray, 64>;
+
+TEST(AsyncPreferenceTest, Paged_WritesOnlyChangedPages) {
+    MockAsyncPreferenceKV kv;
+
+    AsyncPreference<PagedArray, PagedArraySerializer> pref(kv, "ns", "key");
+
+    // First save should write everything: 4 pages + size
+    pref.valueUpdateBegin();
+    pref.get()[0] = 1;
+    pref.valueUpdateEnd();
+    pref.tick();
+    EXPECT_EQ(kv.writes, 5u);
+
+    // Change in the second page => single write, size record is not re-read
+    kv.writes = 0;
+    kv.lengths = 0;
+    pref.valueUpdateBegin();
+    pref.get()[20] = 2;
+    pref.valueUpdateEnd();
+    pref.tick();
+    EXPECT_EQ(kv.writes, 1u);
+    EXPECT_EQ(kv.lengths, 0u);
+
+    // No changes => no writes
+    kv.writes = 0;
+    pref.set(pref.get());
+    pref.tick();
+    EXPECT_EQ(kv.writes, 0u);
+
+    AsyncPreference<PagedArray, PagedArraySerializer> pref2(kv, "ns", "key");
+    EXPECT_EQ(pref2.get()[0], 1u);
+    EXPECT_EQ(pref2.get()[20], 2u);
+
+    // Loaded value should be in sync with storage, so only changes are written
+    kv.writes = 0;
+    pref2.valueUpdateBegin();
+    pref2.get()[63] = 3;
+    pref2.valueUpdateEnd();
+    pref2.tick();
+    EXPECT_EQ(kv.writes, 1u);
+
+    AsyncPreference<PagedArray, PagedArraySerializer> pref3(kv, "ns", "key");
+    EXPECT_EQ(pref3.get()[63], 3u);
+}
+
+TEST(AsyncPreferenceTest, Paged_Vector) {
+    MockAsyncPreferenceKV kv;
+    using Serializer = async_preference_ns::PagedSerializer<std::vector<uint8_t>, 4>;
+
+    AsyncPreference<std::vector<uint8_t>, Serializer> pref(kv, "ns", "key");
+    pref.set({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10 });
+    pref.tick();
+    EXPECT_EQ(kv.writes, 4u); // 3 pages + size
+
+    // Grow: changed tail page, new page, and size
+    kv.writes = 0;
+    pref.set({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 });
+    pref.tick();
+    EXPECT_EQ(kv.writes, 3u);
+
+    AsyncPreference<std::vector<uint8_t>, Serializer> pref2(kv, "ns", "key");
+    EXPECT_EQ(pref2.get(), std::vector<uint8_t>({ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13 }));
+
+    // Shrink: stale pages are removed
+    pref2.set({ 1, 2 });
+    pref2.tick();
+    EXPECT_EQ(kv.storage.size(), 2u); // Size + 1 page
+
+    AsyncPreference<std::vector<uint8_t>, Serializer> pref3(kv, "ns", "key");
+    EXPECT_EQ(pref3.get(), std::vector<uint8_t>({ 1, 2 }));
+}
+
+TEST(AsyncPreferenceTest, Paged_BrokenOrLegacyData) {
+    MockAsyncPreferenceKV kv;
+
+    PagedArray data{};
+    data[5] = 55;
+
+    // Legacy: whole value under base key
+    AsyncPreference<PagedArray> legacy(kv, "ns", "key");
+    legacy.set(data);
+    legacy.tick();
+
+    AsyncPreference<PagedArray, PagedArraySerializer> pref(kv, "ns", "key");
+    EXPECT_EQ(pref.get()[5], 55u);
+
+    // Should migrate to paged format on next save
+    pref.valueUpdateBegin();
+    pref.get()[6] = 66;
+    pref.valueUpdateEnd();
+    pref.tick();
+    EXPECT_EQ(kv.length({"ns", "key"}), sizeof(uint32_t));
+
+    // Missing page => ignore data
+    kv.storage.erase(MockAsyncPreferenceKV::id(PreferenceKey("ns", "key").pageKey(2)));
+    AsyncPreference<PagedArray, PagedArraySerializer> pref2(kv, "ns", "key");
+    EXPECT_EQ(pref2.get()[5], 0u);
+
+    // Broken data should be rewritten completely on the next save
+    kv.writes = 0;
+    pref2.valueUpdateBegin();
+    pref2.get()[7] = 77;
+    pref2.valueUpdateEnd();
+    pref2.tick();
+    EXPECT_EQ(kv.writes, 4u);
+
+    AsyncPreference<PagedArray, PagedArraySerializer> pref3(kv, "ns", "key");
+    EXPECT_EQ(pref3.get()[7], 77u);
+}
+
+TEST(AsyncPreferenceTest, WriterPreloadsGroupedByNamespace) {
+    MockAsyncPreferenceKV kv;
+
+    {
+        AsyncPreference<int32_t> p(kv, "b", "key1");
+        p.set(11);
+        p.tick();
+    }
+
+    AsyncPreference<int32_t> a1(kv, "a", "key1", 5);
+    AsyncPreference<int32_t> b1(kv, "b", "key1");
+    AsyncPreference<int32_t> a2(kv, "a", "key2", 6);
+
+    AsyncPreferenceWriter writer;
+    writer.add(a1);
+    writer.add(b1);
+    writer.add(a2);
+
+    writer.preload(kv);
+    EXPECT_EQ(kv.batches, std::vector<std::string>({ "a", "b" }));
+
+    // Values should be served from memory, even for missing keys
+    kv.lengths = 0;
+    EXPECT_EQ(a1.get(), 5);
+    EXPECT_EQ(b1.get(), 11);
+    EXPECT_EQ(a2.get(), 6);
+    EXPECT_EQ(kv.lengths, 0u);
+}
+
+TEST(AsyncPreferenceTest, WriterPreloadWaitsForTick) {
+    // Slow write, to catch preload in the middle of writer tick
+    class SlowKV : public MockAsyncPreferenceKV {
+    public:
+        std::atomic<bool> writing{false};
+        std::atomic<bool> overlapped{false};
+
+        void write(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+            writing = true;
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            MockAsyncPreferenceKV::write(key, buffer, length);
+            writing = false;
+        }
+
+        void batchBegin(const char* ns) override {
+            if (writing) overlapped = true;
+            MockAsyncPreferenceKV::batchBegin(ns);
+        }
+    };
+
+    SlowKV kv;
+    AsyncPreference<int32_t> a(kv, "a", "key");
+    AsyncPreference<int32_t> b(kv, "b", "key");
+
+    AsyncPreferenceWriter writer;
+    writer.add(a);
+    a.set(1);
+
+    std::thread writer_thread([&writer]() { writer.tick(); });
+    while (!kv.writing) std::this_thread::yield();
+
+    // Registration & preload after writer start
+    writer.add(b);
+    writer.preload(kv);
+    writer_thread.join();
+
+    EXPECT_FALSE(kv.overlapped);
+    EXPECT_EQ(kv.batches, std::vector<std::string>({ "a", "b" }));
+}
+
+static uint32_t fake_time = 0;
+
+TEST(AsyncPreferenceTest, WriterFlush) {
+    MockAsyncPreferenceKV kv;
+    AsyncPreference<int32_t> pref(kv, "ns", "key");
+
+    fake_time = 0;
+    AsyncPreferenceWriter writer(10000, []() { return fake_time; });
+    writer.add(pref);
+
+    pref.set(5);
+    EXPECT_TRUE(writer.hasPending());
+
+    // Periodic tick waits, flush writes immediately
+    writer.tick();
+    EXPECT_EQ(kv.writes, 0u);
+    EXPECT_TRUE(writer.flush());
+    EXPECT_EQ(kv.writes, 1u);
+    EXPECT_FALSE(writer.hasPending());
+
+    // Nothing to write
+    EXPECT_TRUE(writer.flush());
+    EXPECT_EQ(kv.writes, 1u);
+}
+
+static int wakes = 0;
+
+TEST(AsyncPreferenceTest, WriterDeadlines) {
+    MockAsyncPreferenceKV kv;
+    AsyncPreference<int32_t> pref(kv, "ns", "key");
+
+    fake_time = 0;
+    AsyncPreferenceWriter writer(100, []() { return fake_time; });
+    writer.add(pref);
+
+    wakes = 0;
+    writer.setWakeHandler([]() { wakes++; });
+
+    // Nothing to do => sleep until woken
+    fake_time = 100;
+    EXPECT_EQ(writer.tick(), AsyncPreferenceWriter::NEVER);
+
+    // Value change wakes writer, it waits for the rest of period
+    pref.set(5);
+    EXPECT_EQ(wakes, 1);
+    fake_time = 130;
+    EXPECT_EQ(writer.tick(), 70u);
+    EXPECT_EQ(kv.writes, 0u);
+
+    fake_time = 200;
+    EXPECT_EQ(writer.tick(), AsyncPreferenceWriter::NEVER);
+    EXPECT_EQ(kv.writes, 1u);
+
+    // Torn snapshot is retried after period
+    pref.valueUpdateBegin();
+    fake_time = 300;
+    EXPECT_EQ(writer.tick(), 100u);
+    pref.valueUpdateEnd();
+    EXPECT_EQ(wakes, 2);
+
+    // Async flush wakes writer too
+    writer.flushAsync();
+    EXPECT_EQ(wakes, 3);
+    EXPECT_EQ(writer.tick(), AsyncPreferenceWriter::NEVER);
+    EXPECT_EQ(kv.writes, 2u);
+}
+
+TEST(AsyncPreferenceTest, WriterFlushTimeout) {
+    MockAsyncPreferenceKV kv;
+    AsyncPreference<int32_t> pref(kv, "ns", "key");
+
+    AsyncPreferenceWriter writer;
+    writer.add(pref);
+
+    // Value update in progress, snapshot is not possible
+    pref.valueUpdateBegin();
+    EXPECT_FALSE(writer.flush(5));
+    EXPECT_EQ(kv.writes, 0u);
+
+    pref.valueUpdateEnd();
+    EXPECT_TRUE(writer.flush(5));
+    EXPECT_EQ(kv.writes, 1u);
+}
+
+TEST(AsyncPreferenceTest, WriterFlushAsync) {
+    MockAsyncPreferenceKV kv;
+    AsyncPreference<int32_t> pref(kv, "ns", "key");
+
+    fake_time = 0;
+    AsyncPreferenceWriter writer(10000, []() { return fake_time; });
+    writer.add(pref);
+
+    pref.set(5);
+
+    int calls = 0;
+    bool result = false;
+    writer.flushAsync([&](bool ok) { calls++; result = ok; });
+    writer.flushAsync([&](bool ok) { calls++; result = result && ok; });
+    EXPECT_EQ(kv.writes, 0u);
+
+    // Executed by writer tick, regardless of period
+    writer.tick();
+    EXPECT_EQ(kv.writes, 1u);
+    EXPECT_EQ(calls, 2);
+    EXPECT_TRUE(result);
+
+    // Callbacks are called once
+    writer.tick();
+    EXPECT_EQ(calls, 2);
+}
+
+static AsyncPreference<int32_t>* shutdown_pref = nullptr;
+
+TEST(AsyncPreferenceTest, WriterShutdownHooks) {
+    MockAsyncPreferenceKV kv;
+    AsyncPreference<int32_t> pref(kv, "ns", "key");
+    shutdown_pref = &pref;
+
+    AsyncPreferenceWriter writer;
+    writer.add(pref);
+
+    // Hook stores final state, then it should be flushed
+    writer.addShutdownHook([]() { shutdown_pref->set(42); });
+    EXPECT_TRUE(writer.shutdown());
+
+    AsyncPreference<int32_t> pref2(kv, "ns", "key");
+    EXPECT_EQ(pref2.get(), 42);
+    shutdown_pref = nullptr;
+}
+
+static AsyncPreferenceWriter* restart_writer = nullptr;
+static bool restart_flushed = true;
+
+TEST(AsyncPreferenceTest, WriterShutdownFromTick) {
+    MockAsyncPreferenceKV kv;
+    AsyncPreference<int32_t> pref(kv, "ns", "key");
+
+    AsyncPreferenceWriter writer;
+    restart_writer = &writer;
+    writer.add(pref);
+
+    // Restart requested by subscriber, while writer tick holds the lock.
+    // Should give up after timeout instead of deadlock.
+    pref.subscribe([](const int32_t&, void*) { restart_flushed = restart_writer->shutdown(10); });
+    pref.set(1);
+    writer.tick();
+
+    EXPECT_FALSE(restart_flushed);
+    EXPECT_EQ(kv.writes, 1u);
+    restart_writer = nullptr;
+}
+
+static uint32_t fake_time_us = 0;
+
+// Storage, which takes time to write
+class SlowMockKV : public MockAsyncPreferenceKV {
+public:
+    void write(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+        fake_time_us += 100;
+        MockAsyncPreferenceKV::write(key, buffer, length);
+    }
+};
+
+TEST(AsyncPreferenceTest, WriterStats) {
+    SlowMockKV kv;
+    AsyncPreference<int32_t> pref(kv, "ns", "key");
+    AsyncPreference<std::vector<uint8_t>, async_preference_ns::PagedSerializer<std::vector<uint8_t>, 4>> paged(kv, "ns", "paged");
+
+    AsyncPreferenceWriter writer(200, nullptr, []() { return fake_time_us; });
+    writer.add(pref);
+    writer.add(paged);
+
+    pref.set(1);
+    pref.set(2);
+    paged.set(std::vector<uint8_t>(10, 1)); // 3 pages + size
+    writer.tick();
+
+    // No changes => no snapshot
+    writer.tick();
+
+    // Update in progress => torn
+    pref.valueUpdateBegin();
+    writer.tick();
+    pref.valueUpdateEnd();
+
+    const auto& stats = pref.getStats();
+    EXPECT_EQ(stats.snapshots, 1u);
+    EXPECT_EQ(stats.torn, 1u);
+    EXPECT_EQ(stats.writes, 1u);
+    EXPECT_EQ(stats.bytes, sizeof(int32_t));
+    EXPECT_EQ(stats.latency_max_us, 100u);
+    EXPECT_EQ(stats.latencyAvg(), 100u);
+    EXPECT_EQ(stats.latency_histogram[AsyncPreferenceStats::latencyBucket(100)], 1u);
+
+    // Visit all
+    std::vector<std::string> names;
+    uint32_t writes = 0, bytes = 0;
+    writer.visitStats([&](const PreferenceKey& key, const AsyncPreferenceStats& s) {
+        names.push_back(key.name);
+        writes += s.writes;
+        bytes += s.bytes;
+    });
+    EXPECT_EQ(names, std::vector<std::string>({ "key", "paged" }));
+    EXPECT_EQ(writes, 1u + 4u);
+    EXPECT_EQ(bytes, sizeof(int32_t) + 10 + sizeof(uint32_t));
+}
+
+TEST(AsyncPreferenceTest, StatsLatencyBuckets) {
+    EXPECT_EQ(AsyncPreferenceStats::latencyBucket(0), 0u);
+    EXPECT_EQ(AsyncPreferenceStats::latencyBucket(1), 0u);
+    EXPECT_EQ(AsyncPreferenceStats::latencyBucket(2), 1u);
+    EXPECT_EQ(AsyncPreferenceStats::latencyBucket(1023), 9u);
+    EXPECT_EQ(AsyncPreferenceStats::latencyBucket(1024), 10u);
+    EXPECT_EQ(AsyncPreferenceStats::latencyBucket(0xFFFFFFFF), AsyncPreferenceStats::LATENCY_BUCKETS - 1);
+}
+
+TEST(AsyncPreferenceTest, WithoutStats) {
+    using Plain = AsyncPreference<int32_t, void, AsyncPreferenceNoStats>;
+    static_assert(sizeof(Plain) + sizeof(AsyncPreferenceStats) <= sizeof(AsyncPreference<int32_t>),
+        "Disabled stats should take no space");
+
+    MockAsyncPreferenceKV kv;
+    Plain pref(kv, "ns", "key");
+
+    AsyncPreferenceWriter writer(200, nullptr, []() { return fake_time_us; });
+    writer.add(pref);
+
+    pref.set(5);
+    writer.tick();
+    EXPECT_EQ(kv.writes, 1u);
+
+    size_t visited = 0;
+    writer.visitStats([&visited](const PreferenceKey&, const AsyncPreferenceStats&) { visited++; });
+    EXPECT_EQ(visited, 0u);
+}
+
+// ETL containers should use fixed storage serializers
+TEST(AsyncPreferenceTest, Etl_String) {
+    MockAsyncPreferenceKV kv;
+
+    using Str = etl::string<8>;
+    static_assert(std::is_same_v<async_preference_ns::SerializerSelector<Str, void>::type,
+        async_preference_ns::BufferSerializer<Str>>, "Should be buffer");
+
+    {
+        AsyncPreference<Str> pref(kv, "ns", "key", "default");
+        EXPECT_EQ(pref.get(), "default");
+        pref.set("hello");
+        pref.tick();
+    }
+
+    AsyncPreference<Str> pref(kv, "ns", "key", "default");
+    EXPECT_EQ(pref.get(), "hello");
+    EXPECT_EQ(pref.get().size(), 5u);
+}
+
+TEST(AsyncPreferenceTest, Etl_StringOverflow) {
+    MockAsyncPreferenceKV kv;
+
+    // Stored value does not fit into capacity => ignore it
+    uint8_t data[20];
+    std::memset(data, 'x', sizeof(data));
+    kv.write(PreferenceKey("ns", "key"), data, sizeof(data));
+
+    AsyncPreference<etl::string<8>> pref(kv, "ns", "key", "default");
+    EXPECT_EQ(pref.get(), "default");
+}
+
+TEST(AsyncPreferenceTest, Etl_Vector) {
+    MockAsyncPreferenceKV kv;
+
+    using Vec = etl::vector<uint16_t, 4>;
+    {
+        AsyncPreference<Vec> pref(kv, "ns", "key");
+        pref.set(Vec{ 1, 2, 3 });
+        pref.tick();
+    }
+
+    AsyncPreference<Vec> pref(kv, "ns", "key");
+    EXPECT_EQ(pref.get(), (Vec{ 1, 2, 3 }));
+
+    // Too many items, or broken item size
+    uint8_t data[10] = {};
+    kv.write(PreferenceKey("ns", "big"), data, 10);
+    kv.write(PreferenceKey("ns", "odd"), data, 3);
+
+    AsyncPreference<Vec> big(kv, "ns", "big", Vec{ 7 });
+    AsyncPreference<Vec> odd(kv, "ns", "odd", Vec{ 7 });
+    EXPECT_EQ(big.get(), Vec{ 7 });
+    EXPECT_EQ(odd.get(), Vec{ 7 });
+
+    // Paged, with capacity check
+    using Paged = async_preference_ns::PagedSerializer<Vec, 4>;
+    {
+        AsyncPreference<Vec, Paged> pref(kv, "ns", "paged");
+        pref.set(Vec{ 5, 6, 7, 8 });
+        pref.tick();
+    }
+    AsyncPreference<Vec, Paged> paged(kv, "ns", "paged");
+    EXPECT_EQ(paged.get(), (Vec{ 5, 6, 7, 8 }));
+
+    AsyncPreference<etl::vector<uint16_t, 2>, async_preference_ns::PagedSerializer<etl::vector<uint16_t, 2>, 4>> small(kv, "ns", "paged");
+    EXPECT_EQ(small.get().size(), 0u);
+}
+
+TEST(AsyncPreferenceTest, Etl_Array) {
+    MockAsyncPreferenceKV kv;
+
+    using Arr = etl::array<int32_t, 3>;
+    static_assert(std::is_same_v<async_preference_ns::SerializerSelector<Arr, void>::type,
+        async_preference_ns::TrivialSerializer<Arr>>, "Should be trivial");
+
+    {
+        AsyncPreference<Arr> pref(kv, "ns", "key");
+        pref.set(Arr{ { 1, -2, 3 } });
+        pref.tick();
+    }
+
+    AsyncPreference<Arr> pref(kv, "ns", "key");
+    EXPECT_EQ(pref.get()[0], 1);
+    EXPECT_EQ(pref.get()[1], -2);
+    EXPECT_EQ(pref.get()[2], 3);
+}
+
+TEST(AsyncPreferenceTest, Subscribers) {
+    MockAsyncPreferenceKV kv;
+    AsyncPreference<int32_t> pref(kv, "ns", "key", 1);
+
+    std::vector<int32_t> values;
+    pref.subscribe([](const int32_t& value, void* ctx) {
+        static_cast<std::vector<int32_t>*>(ctx)->push_back(value);
+    }, &values);
+
+    // Rapid updates are coalesced
+    pref.set(2);
+    pref.set(3);
+    pref.tick();
+    EXPECT_EQ(values, std::vector<int32_t>({ 3 }));
+    EXPECT_EQ(kv.writes, 1u);
+
+    // No changes => no notification
+    pref.tick();
+    pref.set(3);
+    pref.tick();
+    EXPECT_EQ(values, std::vector<int32_t>({ 3 }));
+
+    // Torn snapshot => notify on the next successful one
+    pref.valueUpdateBegin();
+    pref.get() = 4;
+    pref.tick();
+    EXPECT_EQ(values.size(), 1u);
+    pref.valueUpdateEnd();
+    pref.tick();
+    EXPECT_EQ(values, std::vector<int32_t>({ 3, 4 }));
+}
+
+TEST(AsyncPreferenceTest, SubscribersNotifiedFromWriterTickOnly) {
+    MockAsyncPreferenceKV kv;
+    AsyncPreference<int32_t> pref(kv, "ns", "key", 1);
+
+    fake_time = 0;
+    AsyncPreferenceWriter writer(10, []() { return fake_time; });
+    writer.add(pref);
+
+    std::vector<int32_t> values;
+    pref.subscribe([](const int32_t& value, void* ctx) {
+        static_cast<std::vector<int32_t>*>(ctx)->push_back(value);
+    }, &values);
+
+    // Flush can be called from any thread, so it only saves
+    pref.set(2);
+    EXPECT_TRUE(writer.flush());
+    EXPECT_EQ(kv.writes, 1u);
+    EXPECT_TRUE(values.empty());
+
+    // Writer tick delivers notification, without extra writes
+    fake_time = 10;
+    writer.tick();
+    EXPECT_EQ(values, std::vector<int32_t>({ 2 }));
+    EXPECT_EQ(kv.writes, 1u);
+
+    // Async flush runs in writer thread and notifies immediately
+    pref.set(3);
+    writer.flushAsync();
+    writer.tick();
+    EXPECT_EQ(values, std::vector<int32_t>({ 2, 3 }));
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
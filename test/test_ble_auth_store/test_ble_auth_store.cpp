@@ -5,22 +5,30 @@
 // Mock class for IAsyncPreferenceKV
 class MockAsyncPreferenceKV : public IAsyncPreferenceKV {
 public:
-    // Simulate actual storage
+    // Simulate actual storage, indexed by full key name (hash may collide)
     std::map<std::string, std::vector<uint8_t>> storage;
 
-    void write(const std::string& ns, const std::string& key, uint8_t* buffer, size_t length) override {
+    static std::string id(const PreferenceKey& key) {
+        char name[32];
+        key.fullName(name, sizeof(name));
+        return std::string(key.ns) + '\0' + name;
+    }
+
+    void write(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
         std::vector<uint8_t> data(buffer, buffer + length);
-        storage[ns + key] = data;
+        storage[id(key)] = data;
     }
 
-    void read(const std::string& ns, const std::string& key, uint8_t* buffer, size_t length) override {
-        const auto& data = storage[ns + key];
+    void read(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+        const auto& data = storage[id(key)];
         std::memcpy(buffer, data.data(), length);
     }
 
-    size_t length(const std::string& ns, const std::string& key) override {
-        return storage.count(ns + key) ? storage[ns + key].size() : 0;
+    size_t length(const PreferenceKey& key) override {
+        return storage.count(id(key)) ? storage[id(key)].size() : 0;
     }
+
+    void remove(const PreferenceKey& key) override { storage.erase(id(key)); }
 };
 
 const BleAuthId default_client_id = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 };
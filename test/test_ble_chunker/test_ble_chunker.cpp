@@ -149,6 +149,48 @@ TEST_F(BleChunkerTest, ZeroLengthMessageResponse) {
     EXPECT_EQ(BleChunkHead::SIZE, chunker->response[0].size()); // Only the header, no data
 }
 
+TEST_F(BleChunkerTest, StreamedResponseChunks) {
+    // Response bigger than a few chunks, written in small pieces
+    std::vector<uint8_t> expected(600);
+    for (size_t i = 0; i < expected.size(); i++) expected[i] = uint8_t(i);
+
+    chunker->onMessageStream = [&expected](const std::vector<uint8_t>&, BleChunkWriter& writer) {
+        for (size_t i = 0; i < expected.size(); i += 7) {
+            writer.write(expected.data() + i, std::min<size_t>(7, expected.size() - i));
+        }
+    };
+    chunker->consumeChunk(createChunk(5, 0, BleChunkHead::FINAL_CHUNK_FLAG, {'A'}));
+
+    // 240 + 240 + 120
+    ASSERT_EQ(static_cast<size_t>(3), chunker->response.size());
+
+    std::vector<uint8_t> merged;
+    for (size_t i = 0; i < 3; i++) {
+        const auto chunk = chunker->getResponseChunk();
+        BleChunkHead head(chunk);
+        EXPECT_EQ(5, head.messageId);
+        EXPECT_EQ(i, head.sequenceNumber);
+        EXPECT_EQ(i == 2 ? BleChunkHead::FINAL_CHUNK_FLAG : 0, head.flags);
+        EXPECT_LE(chunk.size(), static_cast<size_t>(244));
+        merged.insert(merged.end(), chunk.begin() + BleChunkHead::SIZE, chunk.end());
+        // Read chunks are released right away
+        EXPECT_EQ(2 - i, chunker->response.size());
+    }
+    EXPECT_EQ(expected, merged);
+}
+
+TEST_F(BleChunkerTest, StreamedResponseExactChunk) {
+    // Exactly one full chunk => no empty tail chunk
+    chunker->onMessageStream = [](const std::vector<uint8_t>&, BleChunkWriter& writer) {
+        for (int i = 0; i < 240; i++) writer.write(uint8_t('x'));
+    };
+    chunker->consumeChunk(createChunk(1, 0, BleChunkHead::FINAL_CHUNK_FLAG, {'A'}));
+
+    ASSERT_EQ(static_cast<size_t>(1), chunker->response.size());
+    EXPECT_EQ(static_cast<size_t>(244), chunker->response[0].size());
+    EXPECT_EQ(BleChunkHead::FINAL_CHUNK_FLAG, BleChunkHead(chunker->response[0]).flags);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
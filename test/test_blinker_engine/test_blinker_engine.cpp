@@ -0,0 +1,249 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "blinker/blinker_engine.hpp"
+
+// Records all values, set by engine
+class MockLed : public IBlinkerLED<1> {
+public:
+    static inline std::vector<uint8_t> history;
+    void set(const DataType& value) override { history.push_back(value[0]); }
+};
+
+using TestBlinker = BlinkerEngine<MockLed>;
+
+static constexpr TestBlinker::Action PATTERN[] = { {100, 20}, {200, 20} };
+static_assert(PATTERN[1].period == 20, "Patterns should be constexpr");
+
+TEST(BlinkerEngineTest, OnceLongSequence) {
+    MockLed::history.clear();
+    TestBlinker blinker;
+
+    // Longer than old fixed limit of 20 steps
+
+    ASSERT_TRUE(blinker.once({ {1, 10}, {2, 10}, {3, 10}, {4, 10}, {5, 10}, {6, 10}, {7, 10}, {8, 10},
+        {9, 10}, {10, 10}, {11, 10}, {12, 10}, {13, 10}, {14, 10}, {15, 10}, {16, 10}, {17, 10},
+        {18, 10}, {19, 10}, {20, 10}, {21, 10}, {22, 10}, {23, 10}, {24, 10}, {25, 10} }));
+
+    blinker.tick(1);
+    for (uint32_t t = 11; t <= 300; t += 10) blinker.tick(t);
+
+    // Each step set once, then background restored
+    ASSERT_GE(MockLed::history.size(), 26u);
+    for (uint8_t i = 0; i < 25; i++) EXPECT_EQ(MockLed::history[i], i + 1);
+    EXPECT_EQ(MockLed::history[25], 0);
+}
+
+TEST(BlinkerEngineTest, ConstantPatternLoop) {
+    MockLed::history.clear();
+    TestBlinker blinker;
+
+    ASSERT_TRUE(blinker.loop(PATTERN));
+    blinker.tick(1);
+    for (uint32_t t = 21; t <= 61; t += 20) blinker.tick(t);
+
+    EXPECT_EQ(MockLed::history, std::vector<uint8_t>({ 100, 200, 100, 200 }));
+}
+
+TEST(BlinkerEngineTest, LatestSequenceWins) {
+    MockLed::history.clear();
+    TestBlinker blinker;
+    blinker.tick(1);
+
+    // Unconsumed sequences return to pool, so pool is never exhausted by
+    // single writer.
+    for (int i = 0; i < 10; i++) ASSERT_TRUE(blinker.once({ {uint8_t(i), 10} }));
+
+    blinker.tick(11);
+    blinker.tick(21);
+    EXPECT_EQ(MockLed::history, std::vector<uint8_t>({ 9, 0 }));
+
+    for (int i = 0; i < 10; i++) {
+        ASSERT_TRUE(blinker.once({ {uint8_t(i), 10} }));
+        blinker.tick(31 + i * 10);
+    }
+}
+
+TEST(BlinkerEngineTest, LayersBlend) {
+    BlinkerEngine<MockLed, 3> blinker;
+    blinker.setBlend(1, BlinkerBlend::MAX);
+    blinker.setBlend(2, BlinkerBlend::ADD);
+
+    MockLed::history.clear();
+    blinker.background(10);
+    blinker.loop({ {100, 1000} }, 0);
+    blinker.loop({ {50, 1000} }, 1);
+    blinker.loop({ {200, 1000} }, 2);
+    blinker.tick(1);
+    blinker.tick(11);
+    // override => 100, max => 100, add => 255 (saturated)
+    EXPECT_EQ(MockLed::history.back(), 255);
+
+    blinker.off(2);
+    blinker.tick(21);
+    EXPECT_EQ(MockLed::history.back(), 100);
+
+    // Lower layer stop does not affect upper ones
+    blinker.off(0);
+    blinker.tick(31);
+    EXPECT_EQ(MockLed::history.back(), 50);
+
+    blinker.off(1);
+    blinker.tick(41);
+    EXPECT_EQ(MockLed::history.back(), 10);
+
+    // Nothing changes => no driver updates
+    const size_t count = MockLed::history.size();
+    blinker.tick(51);
+    EXPECT_EQ(MockLed::history.size(), count);
+}
+
+TEST(BlinkerEngineTest, LayersIndependent) {
+    BlinkerEngine<MockLed, 2> blinker;
+
+    MockLed::history.clear();
+    blinker.loop(PATTERN, 0);
+    blinker.tick(1);
+    blinker.tick(21);
+    EXPECT_EQ(MockLed::history.back(), 200);
+
+    // Transient feedback on top, then loop below continues
+    blinker.once({ {7, 20} }, 1);
+    blinker.tick(41);
+    EXPECT_EQ(MockLed::history.back(), 7);
+    blinker.tick(61);
+    EXPECT_EQ(MockLed::history.back(), 200);
+}
+
+TEST(BlinkerEngineTest, CurvesTables) {
+    using namespace blinker_curves_ns;
+
+    for (int c = 0; c < int(BlinkerCurve::COUNT); c++) {
+        EXPECT_EQ(CURVES[c][0], 0);
+        EXPECT_EQ(CURVES[c][PROGRESS_ONE], PROGRESS_ONE);
+        for (uint32_t p = 1; p <= PROGRESS_ONE; p++) EXPECT_GE(CURVES[c][p], CURVES[c][p - 1]);
+    }
+
+    EXPECT_EQ(GAMMA[0], 0);
+    EXPECT_EQ(GAMMA[255], 255);
+    EXPECT_LT(GAMMA[128], 128);
+
+    static_assert(GAMMA[lightness(10)] >= 10 && GAMMA[lightness(10) - 1] < 10, "Inverse gamma should be exact");
+    EXPECT_EQ(lightness(0), 0);
+    EXPECT_EQ(lightness(255), 255);
+
+    // Reciprocal progress matches division, and ends exactly at 1.0
+    for (uint32_t period : { 1u, 7u, 20u, 300u, 5000u }) {
+        const uint32_t r = progressReciprocal(period);
+        for (uint32_t t = 0; t <= period; t++) {
+            const uint32_t exact = t * PROGRESS_ONE / period;
+            EXPECT_LE(progress(t, period, r) - exact, 1u);
+        }
+        EXPECT_EQ(progress(period, period, r), PROGRESS_ONE);
+    }
+    EXPECT_EQ(interpolate(0, 255, PROGRESS_ONE, BlinkerCurve::EXPO), 255);
+    EXPECT_EQ(interpolate(255, 0, PROGRESS_ONE, BlinkerCurve::SINE), 0);
+}
+
+TEST(BlinkerEngineTest, FlowWithCurve) {
+    auto midpoint = [](BlinkerCurve curve) {
+        TestBlinker blinker;
+        blinker.once({ TestBlinker::flowTo(200, 100, curve), {200, 100} });
+        blinker.tick(1);
+        MockLed::history.clear();
+        blinker.tick(51);
+        return MockLed::history.back();
+    };
+
+    const uint8_t linear = midpoint(BlinkerCurve::LINEAR);
+    EXPECT_NEAR(linear, 100, 1);
+    EXPECT_LT(midpoint(BlinkerCurve::EASE_IN), linear);
+    EXPECT_GT(midpoint(BlinkerCurve::EASE_OUT), linear);
+    EXPECT_NEAR(midpoint(BlinkerCurve::EASE_IN_OUT), linear, 2);
+}
+
+TEST(BlinkerEngineTest, GammaOutput) {
+    TestBlinker blinker;
+    blinker.setGamma(true);
+
+    MockLed::history.clear();
+    blinker.once({ {255, 10}, {128, 10}, {64, 10} });
+    for (uint32_t t = 1; t <= 21; t += 10) blinker.tick(t);
+    EXPECT_EQ(MockLed::history, std::vector<uint8_t>({ 255, blinker_curves_ns::GAMMA[128], blinker_curves_ns::GAMMA[64] }));
+}
+
+// RGB strip, counts frame transfers
+class MockStrip : public IBlinkerLED<30 * 3> {
+public:
+    static inline uint32_t flushes = 0;
+    static inline DataType last{};
+    void set(const DataType& value) override { flushes++; last = value; }
+};
+
+TEST(BlinkerEngineTest, StripFlushesOnlyChanges) {
+    using Strip = BlinkerEngine<MockStrip, 2>;
+    MockStrip::flushes = 0;
+    Strip blinker;
+
+    MockStrip::DataType red{};
+    for (size_t i = 0; i < red.size(); i += 3) red[i] = 255;
+
+    // Static step held for many ticks => single transfer
+    blinker.once({ {red, 1000} });
+    for (uint32_t t = 1; t <= 901; t += 10) blinker.tick(t);
+    EXPECT_EQ(MockStrip::flushes, 1u);
+    EXPECT_EQ(MockStrip::last, red);
+
+    // Next step with the same frame => no transfer
+    blinker.loop({ {red, 100}, {red, 100} });
+    for (uint32_t t = 911; t <= 1501; t += 10) blinker.tick(t);
+    EXPECT_EQ(MockStrip::flushes, 1u);
+
+    // Animation, rendered to the same frame every tick => single transfer
+    blinker.once({ Strip::flowTo(MockStrip::DataType{}, 500) }, 1);
+    for (uint32_t t = 1511; t <= 1991; t += 1) blinker.tick(t);
+    EXPECT_EQ(MockStrip::flushes, 2u);
+    EXPECT_EQ(MockStrip::last, MockStrip::DataType{});
+
+    // Animation finished => lower layer is back
+    blinker.tick(2011);
+    blinker.tick(2021);
+    EXPECT_EQ(MockStrip::flushes, 3u);
+    EXPECT_EQ(MockStrip::last, red);
+
+    // Idle => no transfers
+    blinker.off(0);
+    blinker.tick(2531);
+    const uint32_t flushes = MockStrip::flushes;
+    for (uint32_t t = 2541; t <= 5000; t += 10) blinker.tick(t);
+    EXPECT_EQ(MockStrip::flushes, flushes);
+}
+
+TEST(BlinkerEngineTest, TickDeadline) {
+    static int wakes = 0;
+    TestBlinker blinker;
+    blinker.setWakeHandler([]() { wakes++; });
+
+    EXPECT_EQ(blinker.tick(1), TestBlinker::NEVER);
+
+    blinker.once({ {100, 300}, TestBlinker::flowTo(0, 100), {0, 0} });
+    EXPECT_EQ(wakes, 1);
+
+    // Sequence starts at pickup, static step runs to its end
+    EXPECT_EQ(blinker.tick(51), 300u);
+    EXPECT_EQ(blinker.tick(251), 100u);
+    // Animation needs frames
+    EXPECT_EQ(blinker.tick(351), TestBlinker::FRAME_PERIOD);
+    EXPECT_EQ(blinker.tick(441), 10u);
+    // Finished, background restored in time
+    MockLed::history.clear();
+    EXPECT_EQ(blinker.tick(451), TestBlinker::NEVER);
+    EXPECT_EQ(MockLed::history, std::vector<uint8_t>({ 0 }));
+
+    blinker.loop({ {0, 0}, {0, 0} });
+    EXPECT_EQ(blinker.tick(461), TestBlinker::FRAME_PERIOD); // Zero-length loop must not spin
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
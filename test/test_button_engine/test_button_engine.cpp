@@ -0,0 +1,210 @@
+#include <gtest/gtest.h>
+#include <deque>
+#include <vector>
+#include "button/button_engine.hpp"
+
+static std::vector<ButtonEventId> events;
+
+static void collect(ButtonEventId event) { events.push_back(event); }
+
+// Polling driver, with level controlled by test
+struct PollDriver {
+    static inline bool level = false;
+    bool get() { return level; }
+};
+
+// Edge driver, with edges queued by test
+struct EdgeDriver {
+    static inline std::deque<ButtonEdge> edges;
+    static inline int polls = 0;
+
+    bool popEdge(ButtonEdge& edge) {
+        polls++;
+        if (edges.empty()) return false;
+        edge = edges.front();
+        edges.pop_front();
+        return true;
+    }
+};
+
+TEST(ButtonEngineTest, InvalidTimingFallsBackToDefaults) {
+    ButtonEngine<PollDriver> engine;
+
+    ButtonTiming timing;
+    timing.short_press = 200;
+    EXPECT_TRUE(engine.setTiming(timing));
+    EXPECT_EQ(engine.getTiming().short_press, 200);
+
+    ButtonTiming bad = timing;
+    bad.long_press = bad.short_press; // Long press unreachable
+    EXPECT_FALSE(engine.setTiming(bad));
+    EXPECT_EQ(engine.getTiming().short_press, ButtonTiming().short_press);
+
+    bad = timing;
+    bad.short_press = 0; // No clicks gap
+    EXPECT_FALSE(bad.isValid());
+    bad = timing;
+    bad.jitter = 300; // Debounce swallows clicks
+    EXPECT_FALSE(bad.isValid());
+    bad = timing;
+    bad.max_clicks = 0;
+    EXPECT_FALSE(bad.isValid());
+    bad = timing;
+    bad.hold_repeat = 10; // Faster than debounce
+    EXPECT_FALSE(bad.isValid());
+}
+
+TEST(ButtonEngineTest, PollingSinglePress) {
+    events.clear();
+    PollDriver::level = false;
+
+    ButtonEngine<PollDriver> button;
+    button.setEventHandler(collect);
+
+    uint32_t t = 1;
+    auto run = [&](uint32_t until) { for (; t < until; t += 10) button.tick(t); };
+
+    run(100);
+    PollDriver::level = true;
+    run(200);
+    PollDriver::level = false;
+    run(1000);
+
+    EXPECT_EQ(events, std::vector<ButtonEventId>({ ButtonEventId::BUTTON_PRESSED_1X }));
+    EXPECT_TRUE(button.isIdle());
+}
+
+TEST(ButtonEngineTest, EdgesDoublePressWithBounce) {
+    events.clear();
+    EdgeDriver::edges.clear();
+
+    ButtonEngine<EdgeDriver> button;
+    button.setEventHandler(collect);
+
+    // First tick should poll driver, to start capture
+    EdgeDriver::polls = 0;
+    button.tick(1);
+    EXPECT_GT(EdgeDriver::polls, 0);
+    EXPECT_TRUE(button.isIdle());
+
+    // Two presses with bounces, all captured between ticks
+    EdgeDriver::edges = {
+        { 100, true }, { 102, false }, { 103, true },
+        { 200, false },
+        { 300, true },
+        { 400, false }, { 401, true }, { 402, false },
+    };
+    button.tick(410);
+    EXPECT_FALSE(button.isIdle());
+
+    // Only timers are left
+    for (uint32_t t = 420; t < 1500; t += 50) button.tick(t);
+
+    EXPECT_EQ(events, std::vector<ButtonEventId>({ ButtonEventId::BUTTON_PRESSED_2X }));
+    EXPECT_TRUE(button.isIdle());
+}
+
+TEST(ButtonEngineTest, EdgesLongPress) {
+    events.clear();
+    EdgeDriver::edges.clear();
+
+    ButtonEngine<EdgeDriver> button;
+    button.setEventHandler(collect);
+    button.tick(1);
+
+    EdgeDriver::edges = { { 100, true } };
+    for (uint32_t t = 110; t < 3000; t += 100) button.tick(t);
+
+    EdgeDriver::edges = { { 3000, false } };
+    for (uint32_t t = 3010; t < 3200; t += 100) button.tick(t);
+
+    EXPECT_EQ(events, std::vector<ButtonEventId>({
+        ButtonEventId::BUTTON_LONG_PRESS_START, ButtonEventId::BUTTON_LONG_PRESS }));
+    EXPECT_TRUE(button.isIdle());
+}
+
+TEST(ButtonEngineTest, EdgesTimeIsMonotonic) {
+    events.clear();
+    EdgeDriver::edges.clear();
+
+    ButtonEngine<EdgeDriver> button;
+    button.setEventHandler(collect);
+    button.tick(1);
+    button.tick(500);
+
+    // Edges from "past" and "future" are clamped to tick window
+    EdgeDriver::edges = { { 400, true } };
+    button.tick(600);
+    EdgeDriver::edges = { { 900, false } };
+    button.tick(700);
+    for (uint32_t t = 710; t < 2000; t += 50) button.tick(t);
+
+    EXPECT_EQ(events, std::vector<ButtonEventId>({ ButtonEventId::BUTTON_PRESSED_1X }));
+}
+
+TEST(ButtonEngineTest, EdgesDrivenByDeadlines) {
+    using Button = ButtonEngine<EdgeDriver>;
+    events.clear();
+    EdgeDriver::edges.clear();
+
+    Button button;
+    button.setEventHandler(collect);
+    EXPECT_EQ(button.tick(1), Button::NEVER);
+
+    // Run ticks only when asked, or when edge comes (like interrupt wake)
+    uint32_t now = 1, deadline = Button::NEVER;
+    int ticks = 0;
+    auto runUntil = [&](uint32_t until) {
+        while (deadline != Button::NEVER && now + deadline <= until) {
+            now += deadline;
+            deadline = button.tick(now);
+            ticks++;
+        }
+        now = until;
+    };
+    auto edge = [&](uint32_t ts, bool pressed) {
+        runUntil(ts);
+        EdgeDriver::edges.push_back({ ts, pressed });
+        deadline = button.tick(ts);
+        ticks++;
+    };
+
+    // Click, then long press
+    edge(100, true);
+    edge(200, false);
+    edge(400, true);
+    runUntil(10000);
+    edge(10000, false);
+    runUntil(20000);
+
+    EXPECT_EQ(events, std::vector<ButtonEventId>({ ButtonEventId::BUTTON_PRESSED_2X_HOLD }));
+    EXPECT_EQ(deadline, Button::NEVER);
+    EXPECT_TRUE(button.isIdle());
+    // Edges, debounce ends and gesture timeouts only
+    EXPECT_LT(ticks, 15);
+
+    events.clear();
+    ticks = 0;
+    edge(30000, true);
+    runUntil(33000);
+    edge(33000, false);
+    runUntil(40000);
+
+    EXPECT_EQ(events, std::vector<ButtonEventId>({ ButtonEventId::BUTTON_LONG_PRESS_START, ButtonEventId::BUTTON_LONG_PRESS }));
+    EXPECT_EQ(deadline, Button::NEVER);
+    EXPECT_LT(ticks, 10);
+}
+
+TEST(ButtonEngineTest, PollingDeadline) {
+    using Button = ButtonEngine<PollDriver>;
+    PollDriver::level = false;
+
+    Button button;
+    EXPECT_EQ(button.tick(1), Button::POLL_PERIOD);
+    EXPECT_EQ(button.tick(11), Button::POLL_PERIOD);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "button/button_gesture.hpp"
+
+// Table should be built at compile time
+static_assert(button_gesture_ns::TABLE[button_gesture_ns::IDLE][button_gesture_ns::PRESS].to == button_gesture_ns::FIRST_PRESS, "");
+static_assert(!button_gesture_ns::TABLE[button_gesture_ns::IDLE][button_gesture_ns::RELEASE].valid, "");
+
+// Feeds debounced levels with 10 ms steps
+class GestureRunner {
+public:
+    ButtonGesture gesture;
+    ButtonTiming timing;
+    std::vector<ButtonEventId> events;
+    uint32_t t = 0;
+
+    void hold(bool pressed, uint32_t ms) {
+        for (uint32_t end = t + ms; t < end; t += 10) {
+            gesture.update(pressed, t, timing, [this](ButtonEventId e) { events.push_back(e); });
+        }
+    }
+};
+
+TEST(ButtonGestureTest, Clicks) {
+    GestureRunner r;
+    r.hold(false, 100);
+    for (int i = 0; i < 3; i++) { r.hold(true, 100); r.hold(false, 100); }
+    r.hold(false, 1000);
+
+    EXPECT_EQ(r.events, std::vector<ButtonEventId>({ ButtonEventId::BUTTON_PRESSED_3X }));
+    EXPECT_TRUE(r.gesture.isIdle());
+}
+
+TEST(ButtonGestureTest, MaxClicks) {
+    GestureRunner r;
+    r.timing.max_clicks = 2;
+
+    for (int i = 0; i < 3; i++) { r.hold(true, 100); r.hold(false, 100); }
+    r.hold(false, 1000);
+    EXPECT_TRUE(r.events.empty());
+
+    // Above 5 are always ignored
+    r.timing.max_clicks = 10;
+    for (int i = 0; i < 6; i++) { r.hold(true, 100); r.hold(false, 100); }
+    r.hold(false, 1000);
+    EXPECT_TRUE(r.events.empty());
+}
+
+TEST(ButtonGestureTest, LongPressWithRepeat) {
+    GestureRunner r;
+    r.timing.hold_repeat = 300;
+
+    r.hold(true, 2000 + 1000);
+    r.hold(false, 100);
+
+    EXPECT_EQ(r.events, std::vector<ButtonEventId>({
+        ButtonEventId::BUTTON_LONG_PRESS_START,
+        ButtonEventId::BUTTON_LONG_PRESS,
+        ButtonEventId::BUTTON_HOLD_REPEAT,
+        ButtonEventId::BUTTON_HOLD_REPEAT,
+        ButtonEventId::BUTTON_HOLD_REPEAT,
+    }));
+    EXPECT_TRUE(r.gesture.isIdle());
+}
+
+TEST(ButtonGestureTest, LongPressFail) {
+    GestureRunner r;
+    r.hold(true, 1000);
+    r.hold(false, 100);
+
+    EXPECT_EQ(r.events, std::vector<ButtonEventId>({
+        ButtonEventId::BUTTON_LONG_PRESS_START,
+        ButtonEventId::BUTTON_LONG_PRESS_FAIL,
+    }));
+}
+
+TEST(ButtonGestureTest, ClickThenHold) {
+    GestureRunner r;
+    r.hold(true, 100);
+    r.hold(false, 100);
+    r.hold(true, 2000);
+    r.hold(false, 1000);
+
+    EXPECT_EQ(r.events, std::vector<ButtonEventId>({ ButtonEventId::BUTTON_PRESSED_2X_HOLD }));
+}
+
+TEST(ButtonGestureTest, CustomTiming) {
+    GestureRunner r;
+    r.timing.short_press = 200;
+    r.timing.long_press = 600;
+
+    r.hold(true, 700);
+    r.hold(false, 100);
+    EXPECT_EQ(r.events, std::vector<ButtonEventId>({
+        ButtonEventId::BUTTON_LONG_PRESS_START,
+        ButtonEventId::BUTTON_LONG_PRESS,
+    }));
+
+    // Pause > short_press splits series
+    r.events.clear();
+    r.hold(true, 100);
+    r.hold(false, 300);
+    r.hold(true, 100);
+    r.hold(false, 300);
+    EXPECT_EQ(r.events, std::vector<ButtonEventId>({
+        ButtonEventId::BUTTON_PRESSED_1X,
+        ButtonEventId::BUTTON_PRESSED_1X,
+    }));
+}
@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+#include <utility>
+#include <vector>
+#include "button/button_matrix_engine.hpp"
+
+using MatrixEvent = std::pair<ButtonEventId, uint32_t>;
+static std::vector<MatrixEvent> matrix_events;
+
+struct MaskDriver {
+    static inline uint32_t mask = 0;
+    static inline int reads = 0;
+    uint32_t getMask() { reads++; return mask; }
+};
+
+using Keypad = ButtonMatrixEngine<MaskDriver, 8>;
+
+static void run(Keypad& keypad, uint32_t& t, uint32_t until) {
+    for (; t < until; t += 10) keypad.tick(t);
+}
+
+static Keypad makeKeypad() {
+    matrix_events.clear();
+    MaskDriver::mask = 0;
+    return Keypad();
+}
+
+TEST(ButtonMatrixEngineTest, IndependentButtons) {
+    Keypad keypad = makeKeypad();
+    keypad.setEventHandler([](ButtonEventId event, uint32_t buttons) { matrix_events.push_back({ event, buttons }); });
+
+    uint32_t t = 1;
+    run(keypad, t, 100);
+    EXPECT_TRUE(keypad.isIdle());
+
+    // Button 2 click, then button 5 double click
+    MaskDriver::mask = 1u << 2;
+    run(keypad, t, 200);
+    MaskDriver::mask = 0;
+    run(keypad, t, 800);
+
+    MaskDriver::mask = 1u << 5;
+    run(keypad, t, 900);
+    MaskDriver::mask = 0;
+    run(keypad, t, 1000);
+    MaskDriver::mask = 1u << 5;
+    run(keypad, t, 1100);
+    MaskDriver::mask = 0;
+    run(keypad, t, 2000);
+
+    EXPECT_EQ(matrix_events, std::vector<MatrixEvent>({
+        { ButtonEventId::BUTTON_PRESSED_1X, 1u << 2 },
+        { ButtonEventId::BUTTON_PRESSED_2X, 1u << 5 },
+    }));
+    EXPECT_TRUE(keypad.isIdle());
+}
+
+TEST(ButtonMatrixEngineTest, OneReadPerTick) {
+    Keypad keypad = makeKeypad();
+
+    MaskDriver::reads = 0;
+    uint32_t t = 1;
+    MaskDriver::mask = 0xFF;
+    run(keypad, t, 101);
+    EXPECT_EQ(MaskDriver::reads, 10);
+}
+
+TEST(ButtonMatrixEngineTest, BounceFiltered) {
+    Keypad keypad = makeKeypad();
+    keypad.setEventHandler([](ButtonEventId event, uint32_t buttons) { matrix_events.push_back({ event, buttons }); });
+
+    uint32_t t = 1;
+    run(keypad, t, 100);
+
+    // Short spikes should be ignored
+    for (int i = 0; i < 3; i++) {
+        MaskDriver::mask = 1u << 1;
+        keypad.tick(t); t += 10;
+        MaskDriver::mask = 0;
+        keypad.tick(t); t += 10;
+    }
+    run(keypad, t, 1000);
+
+    EXPECT_TRUE(matrix_events.empty());
+    EXPECT_TRUE(keypad.isIdle());
+}
+
+TEST(ButtonMatrixEngineTest, Chord) {
+    Keypad keypad = makeKeypad();
+    keypad.setEventHandler([](ButtonEventId event, uint32_t buttons) { matrix_events.push_back({ event, buttons }); });
+
+    uint32_t t = 1;
+    run(keypad, t, 100);
+
+    // 0 pressed, then 3 joins, then released one by one
+    MaskDriver::mask = 1u << 0;
+    run(keypad, t, 200);
+    MaskDriver::mask = (1u << 0) | (1u << 3);
+    run(keypad, t, 400);
+    MaskDriver::mask = 1u << 3;
+    run(keypad, t, 500);
+    EXPECT_TRUE(matrix_events.empty());
+
+    MaskDriver::mask = 0;
+    run(keypad, t, 1500);
+
+    EXPECT_EQ(matrix_events, std::vector<MatrixEvent>({
+        { ButtonEventId::BUTTON_CHORD, (1u << 0) | (1u << 3) },
+    }));
+    EXPECT_TRUE(keypad.isIdle());
+
+    // Single buttons work after chord
+    matrix_events.clear();
+    MaskDriver::mask = 1u << 3;
+    run(keypad, t, 1600);
+    MaskDriver::mask = 0;
+    run(keypad, t, 2500);
+    EXPECT_EQ(matrix_events, std::vector<MatrixEvent>({ { ButtonEventId::BUTTON_PRESSED_1X, 1u << 3 } }));
+}
+
+TEST(ButtonMatrixEngineTest, ChordCancelsLongPress) {
+    Keypad keypad = makeKeypad();
+    keypad.setEventHandler([](ButtonEventId event, uint32_t buttons) { matrix_events.push_back({ event, buttons }); });
+
+    uint32_t t = 1;
+    run(keypad, t, 100);
+
+    // Long press of 0 started, then 3 joins => long press fails
+    MaskDriver::mask = 1u << 0;
+    run(keypad, t, 1000);
+    EXPECT_EQ(matrix_events, std::vector<MatrixEvent>({ { ButtonEventId::BUTTON_LONG_PRESS_START, 1u << 0 } }));
+
+    MaskDriver::mask = (1u << 0) | (1u << 3);
+    run(keypad, t, 3000);
+    MaskDriver::mask = 0;
+    run(keypad, t, 3500);
+
+    EXPECT_EQ(matrix_events, std::vector<MatrixEvent>({
+        { ButtonEventId::BUTTON_LONG_PRESS_START, 1u << 0 },
+        { ButtonEventId::BUTTON_LONG_PRESS_FAIL, 1u << 0 },
+        { ButtonEventId::BUTTON_CHORD, (1u << 0) | (1u << 3) },
+    }));
+    EXPECT_TRUE(keypad.isIdle());
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 #include "utils/data_guard.hpp"
 #include <string>
+#include <array>
+#include <vector>
 
 TEST(DataGuardTest, SnapshotFailsWithoutWrite) {
     DataGuard<int> dataGuard(5);
@@ -56,6 +58,58 @@ TEST(DataGuardTest, TransactionBlocksSnapshot) {
     EXPECT_EQ(dataGuard.snapshot, "farst");
 }
 
+TEST(DataGuardTest, DirtyRangeOfTrivialType) {
+    DataGuard<std::array<uint32_t, 8>> dataGuard;
+
+    dataGuard.beginWrite();
+    dataGuard.value[2] = 0xFFFFFFFF;
+    dataGuard.value[4] = 0xFFFFFFFF;
+    dataGuard.endWrite();
+
+    ASSERT_TRUE(dataGuard.makeSnapshot());
+    EXPECT_EQ(dataGuard.snapshot[2], 0xFFFFFFFF);
+    EXPECT_EQ(dataGuard.snapshot[4], 0xFFFFFFFF);
+    EXPECT_FALSE(dataGuard.dirty.all);
+    EXPECT_EQ(dataGuard.dirty.from, 2 * sizeof(uint32_t));
+    EXPECT_EQ(dataGuard.dirty.to, 5 * sizeof(uint32_t));
+
+    // Write of the same content => nothing changed
+    dataGuard.writeData(dataGuard.value);
+    ASSERT_TRUE(dataGuard.makeSnapshot());
+    EXPECT_TRUE(dataGuard.dirty.empty());
+}
+
+TEST(DataGuardTest, DirtyRangeOfBuffer) {
+    DataGuard<std::vector<uint16_t>> dataGuard;
+
+    dataGuard.writeData({ 1, 2, 3, 4 });
+    ASSERT_TRUE(dataGuard.makeSnapshot());
+    EXPECT_EQ(dataGuard.snapshot, std::vector<uint16_t>({ 1, 2, 3, 4 }));
+    EXPECT_EQ(dataGuard.dirty.from, 0u);
+    EXPECT_EQ(dataGuard.dirty.to, 8u);
+
+    // Snapshot buffer should be reused when size not grows
+    const uint16_t* snapshot_data = dataGuard.snapshot.data();
+
+    dataGuard.writeData({ 1, 5, 3 });
+    ASSERT_TRUE(dataGuard.makeSnapshot());
+    EXPECT_EQ(dataGuard.snapshot, std::vector<uint16_t>({ 1, 5, 3 }));
+    EXPECT_EQ(dataGuard.snapshot.data(), snapshot_data);
+    // Changed element + truncated tail
+    EXPECT_EQ(dataGuard.dirty.from, 2u);
+    EXPECT_EQ(dataGuard.dirty.to, 8u);
+}
+
+TEST(DataGuardTest, MoveWriteTakesOwnership) {
+    DataGuard<std::string> dataGuard;
+
+    std::string data(100, 'x');
+    const char* buffer = data.data();
+
+    dataGuard.writeData(std::move(data));
+    EXPECT_EQ(dataGuard.value.data(), buffer);
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
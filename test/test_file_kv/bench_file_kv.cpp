@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <map>
+#include "async_preference/file_kv.hpp"
+
+// Benchmark: log-structured storage vs naive rewrite-in-place of the whole
+// file on every write (what a simple "serialize everything" store does).
+
+namespace {
+
+class NaiveFileKV : public IAsyncPreferenceKV {
+public:
+    NaiveFileKV(const std::string& path) : path(path) {}
+
+    uint64_t physical_bytes = 0;
+
+    void write(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+        storage[std::string(key.ns) + '\0' + key.name].assign(buffer, buffer + length);
+        save();
+    }
+
+    void read(const PreferenceKey& key, uint8_t* buffer, size_t length) override {
+        const auto& data = storage[std::string(key.ns) + '\0' + key.name];
+        std::memcpy(buffer, data.data(), std::min(length, data.size()));
+    }
+
+    size_t length(const PreferenceKey& key) override {
+        auto it = storage.find(std::string(key.ns) + '\0' + key.name);
+        return it == storage.end() ? 0 : it->second.size();
+    }
+
+    void remove(const PreferenceKey& key) override {
+        if (storage.erase(std::string(key.ns) + '\0' + key.name)) save();
+    }
+
+private:
+    std::string path;
+    std::map<std::string, std::vector<uint8_t>> storage;
+
+    // Rewrite the whole file
+    void save() {
+        std::FILE* f = std::fopen(path.c_str(), "wb");
+        if (!f) return;
+        for (const auto& item : storage) {
+            const uint32_t sizes[2] = { uint32_t(item.first.size()), uint32_t(item.second.size()) };
+            std::fwrite(sizes, 1, sizeof(sizes), f);
+            std::fwrite(item.first.data(), 1, item.first.size(), f);
+            std::fwrite(item.second.data(), 1, item.second.size(), f);
+            physical_bytes += sizeof(sizes) + item.first.size() + item.second.size();
+        }
+        std::fclose(f);
+    }
+};
+
+// Typical workload: a few big blobs rarely updated + small hot values
+template <typename KV>
+void prefill(KV& kv) {
+    static const PreferenceKey keys[] = { {"ble_auth", "blob0"}, {"ble_auth", "blob1"}, {"ble_auth", "blob2"}, {"ble_auth", "blob3"} };
+    std::vector<uint8_t> blob(200, 0xAA);
+    for (const auto& key : keys) kv.write(key, blob.data(), blob.size());
+}
+
+// Returns average write latency, us
+template <typename KV>
+double run_workload(KV& kv, uint32_t iterations) {
+    static const PreferenceKey keys[] = {
+        {"settings", "hot0"}, {"settings", "hot1"}, {"settings", "hot2"}, {"settings", "hot3"},
+        {"settings", "hot4"}, {"settings", "hot5"}, {"settings", "hot6"}, {"settings", "hot7"}
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        uint64_t value = i;
+        kv.write(keys[i % 8], reinterpret_cast<uint8_t*>(&value), sizeof(value));
+    }
+    const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    return elapsed / iterations;
+}
+
+}
+
+TEST(FileKVBenchmark, WriteAmplificationAndLatency) {
+    const auto dir = std::filesystem::temp_directory_path();
+    const std::string log_path = (dir / "bench_file_kv_log.bin").string();
+    const std::string naive_path = (dir / "bench_file_kv_naive.bin").string();
+    std::remove(log_path.c_str());
+    std::remove(naive_path.c_str());
+
+    constexpr uint32_t ITERATIONS = 2000;
+
+    constexpr double LOGICAL_BYTES = ITERATIONS * sizeof(uint64_t);
+    double log_latency, log_amplification, naive_latency, naive_amplification;
+    {
+        FileAsyncPreferenceKV kv(log_path);
+        prefill(kv);
+        const auto before = kv.getStats().physical_bytes;
+        log_latency = run_workload(kv, ITERATIONS);
+        kv.tick(); // Let compaction run, as writer would do
+        log_amplification = (kv.getStats().physical_bytes - before) / LOGICAL_BYTES;
+    }
+    {
+        NaiveFileKV kv(naive_path);
+        prefill(kv);
+        const auto before = kv.physical_bytes;
+        naive_latency = run_workload(kv, ITERATIONS);
+        naive_amplification = (kv.physical_bytes - before) / LOGICAL_BYTES;
+    }
+
+    std::printf("[ BENCH    ] %-22s %10s %12s\n", "storage", "us/write", "write ampl.");
+    std::printf("[ BENCH    ] %-22s %10.2f %12.2f\n", "log-structured", log_latency, log_amplification);
+    std::printf("[ BENCH    ] %-22s %10.2f %12.2f\n", "naive rewrite", naive_latency, naive_amplification);
+
+    EXPECT_LT(log_amplification, naive_amplification);
+
+    std::remove(log_path.c_str());
+    std::remove(naive_path.c_str());
+}
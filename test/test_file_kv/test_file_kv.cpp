@@ -0,0 +1,242 @@
+#include <gtest/gtest.h>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "async_preference/file_kv.hpp"
+
+class FileKVTest : public ::testing::Test {
+protected:
+    std::string path;
+
+    void SetUp() override {
+        path = (std::filesystem::temp_directory_path() / ("test_file_kv_" + std::string(
+            ::testing::UnitTest::GetInstance()->current_test_info()->name()) + ".log")).string();
+        std::remove(path.c_str());
+    }
+
+    void TearDown() override {
+        std::remove(path.c_str());
+    }
+};
+
+TEST_F(FileKVTest, WriteReadReopen) {
+    {
+        FileAsyncPreferenceKV kv(path);
+        EXPECT_EQ(kv.length({"ns", "key"}), size_t(0));
+
+        int32_t value = 123;
+        kv.write({"ns", "key"}, reinterpret_cast<uint8_t*>(&value), sizeof(value));
+        value = 456;
+        kv.write({"ns", "key"}, reinterpret_cast<uint8_t*>(&value), sizeof(value));
+
+        int32_t out = 0;
+        EXPECT_EQ(kv.length({"ns", "key"}), sizeof(int32_t));
+        kv.read({"ns", "key"}, reinterpret_cast<uint8_t*>(&out), sizeof(out));
+        EXPECT_EQ(out, 456);
+    }
+
+    // Index should be restored from log
+    FileAsyncPreferenceKV kv(path);
+    int32_t out = 0;
+    kv.read({"ns", "key"}, reinterpret_cast<uint8_t*>(&out), sizeof(out));
+    EXPECT_EQ(out, 456);
+}
+
+TEST_F(FileKVTest, NamespacesAreSeparated) {
+    FileAsyncPreferenceKV kv(path);
+
+    uint8_t a = 1, b = 2;
+    kv.write({"ns1", "key"}, &a, 1);
+    kv.write({"ns", "1key"}, &b, 1);
+
+    uint8_t out = 0;
+    kv.read({"ns1", "key"}, &out, 1);
+    EXPECT_EQ(out, 1);
+    kv.read({"ns", "1key"}, &out, 1);
+    EXPECT_EQ(out, 2);
+}
+
+TEST_F(FileKVTest, HashCollisionsKeepKeysApart) {
+    // Different names with the same FNV-1a hash
+    const PreferenceKey a("ns", "k639099"), b("ns", "k1034130");
+    ASSERT_EQ(a.hash, b.hash);
+
+    {
+        FileAsyncPreferenceKV kv(path);
+        uint8_t value = 1;
+        kv.write(a, &value, 1);
+        value = 2;
+        kv.write(b, &value, 1);
+        EXPECT_EQ(kv.getStats().hash_collisions, 1u);
+
+        uint8_t out = 0;
+        kv.read(a, &out, 1);
+        EXPECT_EQ(out, 1);
+        kv.read(b, &out, 1);
+        EXPECT_EQ(out, 2);
+    }
+
+    // And after log replay
+    FileAsyncPreferenceKV kv(path);
+    uint8_t out = 0;
+    kv.read(a, &out, 1);
+    EXPECT_EQ(out, 1);
+    kv.read(b, &out, 1);
+    EXPECT_EQ(out, 2);
+    EXPECT_EQ(kv.length({"ns", "k1"}), size_t(0));
+}
+
+TEST_F(FileKVTest, RecoversFromTornTail) {
+    {
+        FileAsyncPreferenceKV kv(path);
+        int32_t value = 123;
+        kv.write({"ns", "key"}, reinterpret_cast<uint8_t*>(&value), sizeof(value));
+        value = 456;
+        kv.write({"ns", "key"}, reinterpret_cast<uint8_t*>(&value), sizeof(value));
+    }
+
+    // Emulate power loss in the middle of the last record
+    const auto size = std::filesystem::file_size(path);
+    std::filesystem::resize_file(path, size - 2);
+    // ...followed by some garbage
+    std::ofstream(path, std::ios::binary | std::ios::app) << "garbage";
+
+    FileAsyncPreferenceKV kv(path);
+    int32_t out = 0;
+    kv.read({"ns", "key"}, reinterpret_cast<uint8_t*>(&out), sizeof(out));
+    EXPECT_EQ(out, 123);
+    EXPECT_GT(kv.getStats().recovered_tail_bytes, 0u);
+    EXPECT_EQ(std::filesystem::file_size(path), kv.fileSize());
+
+    // Should continue to work after recovery
+    int32_t value = 789;
+    kv.write({"ns", "key"}, reinterpret_cast<uint8_t*>(&value), sizeof(value));
+    FileAsyncPreferenceKV kv2(path);
+    kv2.read({"ns", "key"}, reinterpret_cast<uint8_t*>(&out), sizeof(out));
+    EXPECT_EQ(out, 789);
+}
+
+TEST_F(FileKVTest, RejectsCorruptedRecord) {
+    {
+        FileAsyncPreferenceKV kv(path);
+        int32_t value = 123;
+        kv.write({"ns", "key"}, reinterpret_cast<uint8_t*>(&value), sizeof(value));
+    }
+
+    // Flip the last byte of value
+    std::fstream f(path, std::ios::binary | std::ios::in | std::ios::out);
+    f.seekp(-1, std::ios::end);
+    f.put(0x55);
+    f.close();
+
+    FileAsyncPreferenceKV kv(path);
+    EXPECT_EQ(kv.length({"ns", "key"}), size_t(0));
+}
+
+TEST_F(FileKVTest, CompactionDropsObsoleteRecords) {
+    FileAsyncPreferenceKV kv(path, 100);
+
+    uint32_t a = 0, b = 0;
+    kv.write({"ns", "static"}, reinterpret_cast<uint8_t*>(&b), sizeof(b));
+    for (a = 0; a < 50; a++) kv.write({"ns", "counter"}, reinterpret_cast<uint8_t*>(&a), sizeof(a));
+
+    const size_t size_before = kv.fileSize();
+    kv.tick(); // Should compact
+
+    EXPECT_EQ(kv.getStats().compactions, 1u);
+    EXPECT_LT(kv.fileSize(), size_before);
+    EXPECT_EQ(std::filesystem::file_size(path), kv.fileSize());
+
+    uint32_t out = 0;
+    kv.read({"ns", "counter"}, reinterpret_cast<uint8_t*>(&out), sizeof(out));
+    EXPECT_EQ(out, 49u);
+
+    // Nothing to compact now
+    kv.tick();
+    EXPECT_EQ(kv.getStats().compactions, 1u);
+
+    // Compacted log should survive reopen
+    FileAsyncPreferenceKV kv2(path);
+    kv2.read({"ns", "counter"}, reinterpret_cast<uint8_t*>(&out), sizeof(out));
+    EXPECT_EQ(out, 49u);
+    EXPECT_EQ(kv2.length({"ns", "static"}), sizeof(uint32_t));
+}
+
+TEST_F(FileKVTest, RemoveSurvivesReopenAndCompaction) {
+    uint32_t value = 5;
+    {
+        FileAsyncPreferenceKV kv(path);
+        kv.write({"ns", "a"}, reinterpret_cast<uint8_t*>(&value), sizeof(value));
+        kv.write({"ns", "b"}, reinterpret_cast<uint8_t*>(&value), sizeof(value));
+        kv.remove({"ns", "a"});
+        kv.remove({"ns", "missing"}); // No-op
+        EXPECT_EQ(kv.length({"ns", "a"}), 0u);
+        EXPECT_EQ(kv.getStats().writes, 3u);
+    }
+
+    // Tombstone should be replayed
+    FileAsyncPreferenceKV kv(path);
+    EXPECT_EQ(kv.length({"ns", "a"}), 0u);
+    EXPECT_EQ(kv.length({"ns", "b"}), sizeof(value));
+
+    const size_t size_before = kv.fileSize();
+    EXPECT_TRUE(kv.compact());
+    EXPECT_LT(kv.fileSize(), size_before);
+
+    FileAsyncPreferenceKV kv2(path);
+    EXPECT_EQ(kv2.length({"ns", "a"}), 0u);
+    EXPECT_EQ(kv2.length({"ns", "b"}), sizeof(value));
+}
+
+TEST_F(FileKVTest, RejectsTooLongNames) {
+    FileAsyncPreferenceKV kv(path);
+
+    static const std::string long_name(300, 'x');
+    const PreferenceKey key("ns", long_name.c_str());
+
+    uint8_t value = 1;
+    kv.write(key, &value, 1);
+
+    // Should not be truncated to shorter name
+    EXPECT_EQ(kv.length(key), size_t(0));
+    EXPECT_EQ(kv.fileSize(), size_t(0));
+    EXPECT_EQ(kv.getStats().io_errors, 1u);
+
+    // Storage should stay usable
+    kv.write({"ns", "key"}, &value, 1);
+    EXPECT_EQ(kv.length({"ns", "key"}), size_t(1));
+}
+
+TEST_F(FileKVTest, SurvivesUnopenableFile) {
+    FileAsyncPreferenceKV kv((std::filesystem::temp_directory_path() / "no_such_dir" / "kv.log").string());
+    EXPECT_FALSE(kv.isOpen());
+
+    uint8_t value = 1, out = 0;
+    kv.write({"ns", "key"}, &value, 1);
+    kv.read({"ns", "key"}, &out, 1);
+    kv.tick();
+
+    EXPECT_EQ(kv.length({"ns", "key"}), size_t(0));
+    EXPECT_EQ(out, 0);
+    EXPECT_FALSE(kv.compact());
+    EXPECT_GT(kv.getStats().io_errors, 0u);
+}
+
+TEST_F(FileKVTest, WorksWithAsyncPreference) {
+    {
+        FileAsyncPreferenceKV kv(path);
+        AsyncPreference<std::string> pref(kv, "ns", "key", "default");
+        EXPECT_EQ(pref.get(), "default");
+        pref.set("hello");
+        pref.tick();
+    }
+
+    FileAsyncPreferenceKV kv(path);
+    AsyncPreference<std::string> pref(kv, "ns", "key", "default");
+    EXPECT_EQ(pref.get(), "hello");
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
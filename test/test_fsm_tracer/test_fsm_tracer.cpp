@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+#include "utils/fsm_tracer.hpp"
+
+using Tracer = FsmTracer<4, 4>;
+
+TEST(FsmTracerTest, RingKeepsLatest) {
+    Tracer tracer;
+    Tracer::Record records[8];
+
+    EXPECT_EQ(tracer.getRecords(records, 8), 0u);
+
+    for (uint8_t i = 0; i < 6; i++) tracer.record({ 0, 0, i, 0, 0 });
+
+    // Only the last 4 records, oldest first
+    ASSERT_EQ(tracer.getRecords(records, 8), 4u);
+    for (uint8_t i = 0; i < 4; i++) EXPECT_EQ(records[i].event_id, i + 2);
+
+    // Limited output => the latest ones
+    ASSERT_EQ(tracer.getRecords(records, 2), 2u);
+    EXPECT_EQ(records[0].event_id, 4);
+    EXPECT_EQ(records[1].event_id, 5);
+}
+
+TEST(FsmTracerTest, StateStats) {
+    Tracer tracer;
+
+    tracer.record({ 10, 100, 1, 1, 1 });
+    tracer.record({ 50, 300, 2, 1, 2 });
+    tracer.record({ 5, 7, 3, 2, 1 });
+    // Unknown state should not break anything
+    tracer.record({ 0, 0, 0, 9, 9 });
+
+    auto stats = tracer.getStateStats(1);
+    EXPECT_EQ(stats.events, 2u);
+    EXPECT_EQ(stats.transitions, 1u);
+    EXPECT_EQ(stats.handler_max_us, 300u);
+    EXPECT_EQ(stats.handlerAvg(), 200u);
+    EXPECT_EQ(stats.queue_max_us, 50u);
+    EXPECT_EQ(stats.histogram[Tracer::bucket(100)], 1u);
+    EXPECT_EQ(stats.histogram[Tracer::bucket(300)], 1u);
+
+    EXPECT_EQ(tracer.getStateStats(2).events, 1u);
+    EXPECT_EQ(tracer.getStateStats(3).events, 0u);
+    EXPECT_EQ(tracer.getStateStats(9).events, 0u);
+}
+
+TEST(FsmTracerTest, Buckets) {
+    EXPECT_EQ(Tracer::bucket(0), 0u);
+    EXPECT_EQ(Tracer::bucket(1), 0u);
+    EXPECT_EQ(Tracer::bucket(3), 1u);
+    EXPECT_EQ(Tracer::bucket(1000), 9u);
+    EXPECT_EQ(Tracer::bucket(0xFFFFFFFF), Tracer::HISTOGRAM_BUCKETS - 1);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
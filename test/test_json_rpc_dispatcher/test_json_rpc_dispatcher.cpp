@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "rpc/json_rpc_dispatcher.hpp"
+#include "rpc/ble_chunker.hpp"
 
 // Helpers
 std::vector<uint8_t> s2v(const std::string& str) {
@@ -225,6 +226,141 @@ TEST(JsonRpcDispatcherTest, TestBrokenJsonInput) {
     EXPECT_EQ(expected, result);
 }
 
+int twice(int a) { return a * 2; }
+
+constexpr auto STATIC_METHODS = jrcpd::make_methods(
+    jrcpd::method<twice>("twice"),
+    jrcpd::method<concat>("concat"),
+    jrcpd::method<add_8bits>("add_8bits")
+);
+
+static_assert(jrcpd::compare_names(STATIC_METHODS[0].name, "add_8bits") == 0, "Table should be sorted");
+static_assert(jrcpd::compare_names(STATIC_METHODS[2].name, "twice") == 0, "Table should be sorted");
+
+TEST(JsonRpcDispatcherTest, TestStaticMethods) {
+    JsonRpcDispatcher dispatcher(STATIC_METHODS);
+
+    EXPECT_EQ(dispatcher.dispatch(R"({"method": "add_8bits", "args": [1, 2]})"), R"({"ok":true,"result":3})");
+    EXPECT_EQ(dispatcher.dispatch(R"({"method": "concat", "args": ["a", "b"]})"), R"({"ok":true,"result":"ab"})");
+    EXPECT_EQ(dispatcher.dispatch(R"({"method": "twice", "args": [2]})"), R"({"ok":true,"result":4})");
+    EXPECT_EQ(dispatcher.dispatch(R"({"method": "twice", "args": ["2"]})"), R"({"ok":false,"result":"Argument type mismatch"})");
+
+    // Prefixes and neighbours should not match
+    EXPECT_EQ(dispatcher.dispatch(R"({"method": "twic", "args": [2]})"), R"({"ok":false,"result":"Method not found"})");
+    EXPECT_EQ(dispatcher.dispatch(R"({"method": "a", "args": []})"), R"({"ok":false,"result":"Method not found"})");
+    EXPECT_EQ(dispatcher.dispatch(R"({"method": "zzz", "args": []})"), R"({"ok":false,"result":"Method not found"})");
+    EXPECT_EQ(dispatcher.dispatch(R"({"method": 5, "args": []})"), R"({"ok":false,"result":"Method not found"})");
+}
+
+TEST(JsonRpcDispatcherTest, TestStaticMethodsExtended) {
+    JsonRpcDispatcher dispatcher(STATIC_METHODS);
+    dispatcher.addMethod("noparams", [](){ return 5; });
+
+    EXPECT_EQ(dispatcher.dispatch(R"({"method": "noparams", "args": []})"), R"({"ok":true,"result":5})");
+    EXPECT_EQ(dispatcher.dispatch(R"({"method": "twice", "args": [3]})"), R"({"ok":true,"result":6})");
+}
+
+TEST(JsonRpcDispatcherTest, TestStreamToChunks) {
+    JsonRpcDispatcher dispatcher;
+    dispatcher.addMethod("concat", concat);
+
+    const std::string big(500, 'a');
+    std::string input = R"({"method": "concat", "args": [")" + big + R"(", "b"]})";
+
+    BleChunks chunks;
+    BleChunkWriter writer(chunks, 1, 244);
+    dispatcher.dispatch(input, writer);
+    writer.finish();
+
+    ASSERT_EQ(static_cast<size_t>(3), chunks.size());
+
+    std::string merged;
+    for (const auto& chunk : chunks) merged.append(chunk.begin() + BleChunkHead::SIZE, chunk.end());
+    EXPECT_EQ(R"({"ok":true,"result":")" + big + R"(b"})", merged);
+}
+
+TEST(JsonRpcDispatcherTest, TestMsgPack) {
+    JsonRpcDispatcher dispatcher;
+    dispatcher.addMethod("add_8bits", add_8bits);
+
+    // {"method": "add_8bits", "args": [1, 2]}
+    std::vector<uint8_t> input = { 0x82, 0xa6, 'm', 'e', 't', 'h', 'o', 'd',
+        0xa9, 'a', 'd', 'd', '_', '8', 'b', 'i', 't', 's',
+        0xa4, 'a', 'r', 'g', 's', 0x92, 0x01, 0x02 };
+    // {"ok": true, "result": 3}
+    std::vector<uint8_t> expected = { 0x82, 0xa2, 'o', 'k', 0xc3, 0xa6, 'r', 'e', 's', 'u', 'l', 't', 0x03 };
+
+    std::vector<uint8_t> result;
+    dispatcher.dispatch(input, result);
+    EXPECT_EQ(expected, result);
+
+    // Errors are reported in the request format too
+    input[10] = 'x';
+    dispatcher.dispatch(input, result);
+    ASSERT_FALSE(result.empty());
+    EXPECT_EQ(0x82, result[0]);
+    EXPECT_EQ(0xc2, result[4]); // "ok": false
+
+    // JSON still works with the same dispatcher
+    EXPECT_EQ(R"({"ok":true,"result":3})", dispatcher.dispatch(R"({"method": "add_8bits", "args": [1, 2]})"));
+}
+
+TEST(JsonRpcDispatcherTest, TestDetectFormat) {
+    EXPECT_EQ(jrcpd::Format::JSON, jrcpd::detect_format(std::string("{}")));
+    EXPECT_EQ(jrcpd::Format::JSON, jrcpd::detect_format(std::string(" \n{}")));
+    EXPECT_EQ(jrcpd::Format::JSON, jrcpd::detect_format(std::string("")));
+    EXPECT_EQ(jrcpd::Format::MSGPACK, jrcpd::detect_format(std::vector<uint8_t>({ 0x80 })));
+    EXPECT_EQ(jrcpd::Format::MSGPACK, jrcpd::detect_format(std::vector<uint8_t>({ 0xde, 0x00, 0x10 })));
+    EXPECT_EQ(jrcpd::Format::MSGPACK, jrcpd::detect_format(std::vector<uint8_t>({ 0x91, 0x80 })));
+}
+
+TEST(JsonRpcDispatcherTest, TestBatch) {
+    JsonRpcDispatcher dispatcher(STATIC_METHODS);
+
+    // Results come in order of calls, errors don't break the batch
+    EXPECT_EQ(dispatcher.dispatch(R"([{"method": "twice", "args": [2]}, {"method": "unknown", "args": []}, {"method": "concat", "args": ["a", "b"]}])"),
+        R"([{"ok":true,"result":4},{"ok":false,"result":"Method not found"},{"ok":true,"result":"ab"}])");
+
+    EXPECT_EQ(dispatcher.dispatch(R"([{"method": "twice", "args": ["2"]}])"), R"([{"ok":false,"result":"Argument type mismatch"}])");
+    EXPECT_EQ(dispatcher.dispatch(R"([5])"), R"([{"ok":false,"result":"Method not found"}])");
+    EXPECT_EQ(dispatcher.dispatch(R"([])"), R"([])");
+}
+
+TEST(JsonRpcDispatcherTest, TestBatchLimit) {
+    JsonRpcDispatcher dispatcher(STATIC_METHODS);
+    dispatcher.setMaxBatch(2);
+
+    const std::string call = R"({"method": "twice", "args": [2]})";
+    EXPECT_EQ(dispatcher.dispatch("[" + call + "," + call + "]"), R"([{"ok":true,"result":4},{"ok":true,"result":4}])");
+
+    // Whole batch is rejected, no calls are made
+    EXPECT_EQ(dispatcher.dispatch("[" + call + "," + call + "," + call + "]"),
+        R"({"ok":false,"result":"Too many calls in batch","code":-32600})");
+
+    // Default limit
+    JsonRpcDispatcher defaults(STATIC_METHODS);
+    std::string batch = "[" + call;
+    for (size_t i = 0; i < JsonRpcDispatcher::MAX_BATCH_DEFAULT; i++) batch += "," + call;
+    EXPECT_NE(defaults.dispatch(batch + "]").find(R"("code":-32600)"), std::string::npos);
+}
+
+TEST(JsonRpcDispatcherTest, TestBatchMsgPack) {
+    JsonRpcDispatcher dispatcher(STATIC_METHODS);
+
+    // [{"method": "twice", "args": [2]}, {"method": "twice", "args": [3]}]
+    std::vector<uint8_t> input = { 0x92,
+        0x82, 0xa6, 'm', 'e', 't', 'h', 'o', 'd', 0xa5, 't', 'w', 'i', 'c', 'e', 0xa4, 'a', 'r', 'g', 's', 0x91, 0x02,
+        0x82, 0xa6, 'm', 'e', 't', 'h', 'o', 'd', 0xa5, 't', 'w', 'i', 'c', 'e', 0xa4, 'a', 'r', 'g', 's', 0x91, 0x03 };
+    // [{"ok": true, "result": 4}, {"ok": true, "result": 6}]
+    std::vector<uint8_t> expected = { 0x92,
+        0x82, 0xa2, 'o', 'k', 0xc3, 0xa6, 'r', 'e', 's', 'u', 'l', 't', 0x04,
+        0x82, 0xa2, 'o', 'k', 0xc3, 0xa6, 'r', 'e', 's', 'u', 'l', 't', 0x06 };
+
+    std::vector<uint8_t> result;
+    dispatcher.dispatch(input, result);
+    EXPECT_EQ(expected, result);
+}
+
 // Main function to run the tests
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
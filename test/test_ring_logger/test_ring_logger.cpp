@@ -37,6 +37,24 @@ TEST(RingLoggerTest, BasicPushAndLpush) {
     EXPECT_STREQ(buffer, "[ERROR] [foo]: Error message: 456");
 }
 
+static int pushes = 0;
+
+TEST(RingLoggerTest, PushHandler) {
+    RingLogger<> logger;
+    char buffer[1024] = {0};
+
+    pushes = 0;
+    logger.setPushHandler([]() { pushes++; });
+
+    logger.push_info("Hello");
+    logger.lpush_info<foo_label>("Hello");
+    EXPECT_EQ(pushes, 2);
+
+    // Pull should not call it
+    ASSERT_TRUE(logger.pull(buffer, sizeof(buffer)));
+    EXPECT_EQ(pushes, 2);
+}
+
 TEST(RingLoggerTest, IgnoreLabel) {
     RingLogger<10 * 1024, RingLoggerLevel::DEBUG, 512, 10, nullptr, ignored_labels_list> logger;
     char buffer[1024] = {0};
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <chrono>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "utils/seqlock.hpp"
+#include "utils/ring_queue.hpp"
+#include "utils/triple_buffer.hpp"
+
+// Contention benchmarks of sync primitives vs plain mutex-based equivalents.
+// Numbers are informative only, depend on host, and are not checked.
+
+namespace {
+
+using Payload = std::array<uint32_t, 16>;
+constexpr uint32_t WRITES = 100000;
+
+template <typename Fn>
+double measure_ms(Fn&& fn) {
+    const auto start = std::chrono::steady_clock::now();
+    fn();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 1 writer + N readers, readers spin on fresh data until writer finishes
+template <typename Write, typename Read>
+std::pair<double, uint64_t> run_cell(uint32_t readers_count, Write&& write, Read&& read) {
+    std::atomic<bool> done{false};
+    std::atomic<uint64_t> reads{0};
+    std::atomic<uint32_t> started{0};
+
+    std::vector<std::thread> readers;
+    for (uint32_t r = 0; r < readers_count; r++) {
+        readers.emplace_back([&, r]() {
+            uint64_t local = 0;
+            started++;
+            while (!done.load(std::memory_order_relaxed)) if (read(r)) local++;
+            reads += local;
+        });
+    }
+
+    while (started.load() < readers_count) std::this_thread::yield();
+
+    const double ms = measure_ms([&]() {
+        Payload data;
+        for (uint32_t i = 0; i < WRITES; i++) { data.fill(i); write(data); }
+    });
+
+    done = true;
+    for (auto& t : readers) t.join();
+    return { ms, reads.load() };
+}
+
+void print(const char* name, double ms, uint64_t reads) {
+    std::printf("[ BENCH    ] %-28s %8.2f ms %12llu reads\n", name, ms, static_cast<unsigned long long>(reads));
+}
+
+}
+
+TEST(SyncBenchmark, VersionedCellContention) {
+    constexpr uint32_t READERS = 3;
+
+    {
+        SeqLock<Payload> lock;
+        std::array<SeqLock<Payload>::Cursor, READERS> cursors{};
+        Payload out;
+        auto r = run_cell(READERS,
+            [&](const Payload& d) { lock.write(d); },
+            [&](uint32_t i) { return lock.tryRead(out, cursors[i]); });
+        print("seqlock, 3 readers", r.first, r.second);
+    }
+    {
+        std::mutex mutex;
+        Payload cell{};
+        uint32_t version = 0;
+        std::array<uint32_t, READERS> seen{};
+        auto r = run_cell(READERS,
+            [&](const Payload& d) { std::lock_guard<std::mutex> l(mutex); cell = d; version++; },
+            [&](uint32_t i) {
+                std::lock_guard<std::mutex> l(mutex);
+                if (seen[i] == version) return false;
+                Payload out = cell;
+                (void)out;
+                seen[i] = version;
+                return true;
+            });
+        print("mutex, 3 readers", r.first, r.second);
+    }
+    {
+        TripleBuffer<Payload> buffer;
+        auto r = run_cell(1,
+            [&](const Payload& d) { buffer.writeBuffer() = d; buffer.publish(); },
+            [&](uint32_t) { return buffer.update(); });
+        print("triple buffer, 1 reader", r.first, r.second);
+    }
+}
+
+TEST(SyncBenchmark, QueueContention) {
+    constexpr uint32_t PRODUCERS = 3;
+    constexpr uint32_t ITEMS = 100000;
+
+    auto run = [&](auto&& push, auto&& pop) {
+        return measure_ms([&]() {
+            std::vector<std::thread> producers;
+            for (uint32_t p = 0; p < PRODUCERS; p++) {
+                producers.emplace_back([&]() {
+                    for (uint32_t i = 0; i < ITEMS; i++) while (!push(i)) std::this_thread::yield();
+                });
+            }
+            uint32_t received = 0, item;
+            while (received < PRODUCERS * ITEMS) {
+                if (pop(item)) received++;
+                else std::this_thread::yield();
+            }
+            for (auto& t : producers) t.join();
+        });
+    };
+
+    MpscRingQueue<uint32_t, 256> ring;
+    print("mpsc ring, 3 producers", run(
+        [&](uint32_t v) { return ring.push(v); },
+        [&](uint32_t& v) { return ring.pop(v); }), PRODUCERS * ITEMS);
+
+    std::mutex mutex;
+    std::deque<uint32_t> deque;
+    print("mutex + deque, 3 producers", run(
+        [&](uint32_t v) { std::lock_guard<std::mutex> l(mutex); if (deque.size() >= 256) return false; deque.push_back(v); return true; },
+        [&](uint32_t& v) { std::lock_guard<std::mutex> l(mutex); if (deque.empty()) return false; v = deque.front(); deque.pop_front(); return true; }), PRODUCERS * ITEMS);
+}
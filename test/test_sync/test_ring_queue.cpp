@@ -0,0 +1,80 @@
+#include <gtest/gtest.h>
+#include <thread>
+#include <vector>
+#include "utils/ring_queue.hpp"
+
+TEST(RingQueueTest, SpscFifoAndOverflow) {
+    SpscRingQueue<int, 4> queue;
+    int out;
+
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.pop(out));
+
+    for (int i = 0; i < 4; i++) EXPECT_TRUE(queue.push(i));
+    EXPECT_FALSE(queue.push(4)); // Full
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(queue.pop(out));
+        EXPECT_EQ(out, i);
+    }
+    EXPECT_TRUE(queue.empty());
+
+    // Wrap around
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(queue.push(i));
+        ASSERT_TRUE(queue.pop(out));
+        EXPECT_EQ(out, i);
+    }
+}
+
+TEST(RingQueueTest, MpscFifoAndOverflow) {
+    MpscRingQueue<int, 4> queue;
+    int out;
+
+    EXPECT_FALSE(queue.pop(out));
+
+    for (int i = 0; i < 4; i++) EXPECT_TRUE(queue.push(i));
+    EXPECT_FALSE(queue.push(4)); // Full
+
+    for (int i = 0; i < 4; i++) {
+        ASSERT_TRUE(queue.pop(out));
+        EXPECT_EQ(out, i);
+    }
+
+    for (int i = 0; i < 10; i++) {
+        EXPECT_TRUE(queue.push(i));
+        ASSERT_TRUE(queue.pop(out));
+        EXPECT_EQ(out, i);
+    }
+}
+
+TEST(RingQueueTest, MpscConcurrentProducers) {
+    MpscRingQueue<uint32_t, 64> queue;
+
+    constexpr uint32_t PRODUCERS = 3;
+    constexpr uint32_t ITEMS = 20000;
+
+    std::vector<std::thread> producers;
+    for (uint32_t p = 0; p < PRODUCERS; p++) {
+        producers.emplace_back([&queue, p]() {
+            for (uint32_t i = 0; i < ITEMS; i++) {
+                while (!queue.push((p << 24) | i)) std::this_thread::yield();
+            }
+        });
+    }
+
+    // Items of each producer should come in order, without losses
+    std::vector<uint32_t> next(PRODUCERS, 0);
+    uint32_t received = 0;
+    while (received < PRODUCERS * ITEMS) {
+        uint32_t item;
+        if (!queue.pop(item)) { std::this_thread::yield(); continue; }
+
+        const uint32_t p = item >> 24;
+        ASSERT_EQ(item & 0xFFFFFF, next[p]);
+        next[p]++;
+        received++;
+    }
+
+    for (auto& t : producers) t.join();
+}
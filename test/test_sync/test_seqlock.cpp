@@ -0,0 +1,84 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <thread>
+#include "utils/seqlock.hpp"
+
+TEST(SeqLockTest, ReadersHaveOwnCursors) {
+    SeqLock<int> lock(5);
+    SeqLock<int>::Cursor reader1, reader2;
+
+    int out1 = 0, out2 = 0;
+
+    lock.write(10);
+    EXPECT_TRUE(lock.changedSince(reader1));
+    EXPECT_TRUE(lock.changedSince(reader2));
+
+    EXPECT_TRUE(lock.tryRead(out1, reader1));
+    EXPECT_EQ(out1, 10);
+    EXPECT_FALSE(lock.changedSince(reader1));
+    // Other reader should not be affected
+    EXPECT_TRUE(lock.changedSince(reader2));
+
+    EXPECT_TRUE(lock.tryRead(out2, reader2));
+    EXPECT_EQ(out2, 10);
+
+    // Nothing new
+    EXPECT_FALSE(lock.tryRead(out1, reader1));
+    EXPECT_FALSE(lock.tryRead(out2, reader2));
+}
+
+TEST(SeqLockTest, ReadFailsDuringWrite) {
+    SeqLockCounter<> counter;
+
+    counter.beginWrite();
+    const uint32_t version = counter.readBegin();
+    EXPECT_FALSE(counter.readValidate(version));
+    counter.endWrite();
+
+    const uint32_t version2 = counter.readBegin();
+    EXPECT_TRUE(counter.readValidate(version2));
+
+    // Write after read start => invalid
+    counter.beginWrite();
+    counter.endWrite();
+    EXPECT_FALSE(counter.readValidate(version2));
+}
+
+TEST(SeqLockTest, MultiWriterConsistency) {
+    using Data = std::array<uint32_t, 16>;
+    SeqLock<Data, true> lock;
+
+    constexpr uint32_t WRITES = 20000;
+    std::atomic<bool> done{false};
+    std::atomic<uint32_t> torn{0};
+
+    auto writer = [&](uint32_t base) {
+        Data data;
+        for (uint32_t i = 0; i < WRITES; i++) {
+            data.fill(base + i);
+            lock.write(data);
+        }
+    };
+
+    auto reader = [&]() {
+        while (!done.load()) {
+            const Data data = lock.read();
+            for (auto v : data) if (v != data[0]) torn++;
+        }
+    };
+
+    std::thread r1(reader), r2(reader);
+    std::thread w1(writer, 0), w2(writer, 1000000);
+    w1.join();
+    w2.join();
+    done = true;
+    r1.join();
+    r2.join();
+
+    EXPECT_EQ(torn.load(), 0u);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
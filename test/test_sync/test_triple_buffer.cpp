@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include <array>
+#include <thread>
+#include "utils/triple_buffer.hpp"
+
+TEST(TripleBufferTest, LatestValueWins) {
+    TripleBuffer<int> buffer(0);
+    int out = -1;
+
+    EXPECT_FALSE(buffer.read(out));
+
+    buffer.write(1);
+    buffer.write(2);
+    ASSERT_TRUE(buffer.read(out));
+    EXPECT_EQ(out, 2);
+
+    // Nothing new
+    EXPECT_FALSE(buffer.read(out));
+    EXPECT_EQ(buffer.readBuffer(), 2);
+
+    // In-place fill
+    buffer.writeBuffer() = 3;
+    buffer.publish();
+    ASSERT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.readBuffer(), 3);
+}
+
+TEST(TripleBufferTest, ConcurrentNoTearing) {
+    using Data = std::array<uint32_t, 16>;
+    TripleBuffer<Data> buffer;
+
+    constexpr uint32_t WRITES = 50000;
+    std::atomic<bool> done{false};
+
+    std::thread writer([&]() {
+        for (uint32_t i = 1; i <= WRITES; i++) {
+            buffer.writeBuffer().fill(i);
+            buffer.publish();
+        }
+        done = true;
+    });
+
+    uint32_t torn = 0, prev = 0, regressions = 0;
+    while (true) {
+        const bool finished = done.load();
+        if (!buffer.update()) {
+            if (finished) break;
+            continue;
+        }
+        const Data& data = buffer.readBuffer();
+        for (auto v : data) if (v != data[0]) torn++;
+        if (data[0] < prev) regressions++;
+        prev = data[0];
+    }
+    writer.join();
+
+    EXPECT_EQ(torn, 0u);
+    EXPECT_EQ(regressions, 0u);
+}
@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+#include <vector>
+#include "utils/tick_scheduler.hpp"
+
+static std::vector<uint32_t> runs_a;
+static std::vector<uint32_t> runs_b;
+static uint32_t delay_b = 0;
+
+TEST(TickSchedulerTest, RunsByDeadlines) {
+    runs_a.clear();
+    runs_b.clear();
+    delay_b = 25;
+
+    TickScheduler<> scheduler;
+    EXPECT_EQ(scheduler.add([](uint32_t now) { runs_a.push_back(now); return 10u; }), 0);
+    EXPECT_EQ(scheduler.add([](uint32_t now) { runs_b.push_back(now); return delay_b; }), 1);
+
+    // All jobs run first time, then nearest deadline returned
+    EXPECT_EQ(scheduler.run(0), 10u);
+
+    // Not due yet
+    EXPECT_EQ(scheduler.run(5), 5u);
+    EXPECT_EQ(runs_a.size(), 1u);
+
+    EXPECT_EQ(scheduler.run(10), 10u);
+    EXPECT_EQ(scheduler.run(20), 5u);
+    EXPECT_EQ(scheduler.run(25), 5u);
+
+    EXPECT_EQ(runs_a, std::vector<uint32_t>({ 0, 10, 20 }));
+    EXPECT_EQ(runs_b, std::vector<uint32_t>({ 0, 25 }));
+
+    // Late run => job is due immediately
+    EXPECT_EQ(scheduler.run(100), 10u);
+    EXPECT_EQ(runs_a.back(), 100u);
+}
+
+TEST(TickSchedulerTest, IdleAndWake) {
+    runs_b.clear();
+    delay_b = TickScheduler<>::NEVER;
+
+    TickScheduler<> scheduler;
+    const int id = scheduler.add([](uint32_t now) { runs_b.push_back(now); return delay_b; });
+
+    // Nothing to do => sleep forever
+    EXPECT_EQ(scheduler.run(0), TickScheduler<>::NEVER);
+    EXPECT_EQ(scheduler.run(1000), TickScheduler<>::NEVER);
+    EXPECT_EQ(runs_b.size(), 1u);
+
+    // Wake makes job due
+    scheduler.wake(id);
+    delay_b = 50;
+    EXPECT_EQ(scheduler.run(2000), 50u);
+    EXPECT_EQ(runs_b, std::vector<uint32_t>({ 0, 2000 }));
+
+    // Bad ids are ignored
+    scheduler.wake(-1);
+    scheduler.wake(5);
+    EXPECT_EQ(scheduler.run(2010), 40u);
+}
+
+TEST(TickSchedulerTest, TimeOverflow) {
+    runs_a.clear();
+
+    TickScheduler<> scheduler;
+    scheduler.add([](uint32_t now) { runs_a.push_back(now); return 10u; });
+
+    EXPECT_EQ(scheduler.run(0xFFFFFFFA), 10u);
+    EXPECT_EQ(scheduler.run(0xFFFFFFFF), 5u);
+    EXPECT_EQ(scheduler.run(4), 10u);
+    EXPECT_EQ(runs_a, std::vector<uint32_t>({ 0xFFFFFFFA, 4 }));
+}
+
+TEST(TickSchedulerTest, Capacity) {
+    TickScheduler<2> scheduler;
+    auto job = [](uint32_t) { return 1u; };
+
+    EXPECT_EQ(scheduler.add(job), 0);
+    EXPECT_EQ(scheduler.add(job), 1);
+    EXPECT_EQ(scheduler.add(job), -1);
+}
+
+int main(int argc, char **argv) {
+    ::testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}